@@ -0,0 +1,182 @@
+// Decodes the same small XZ, ZSTD and bzip2 blobs over and over, once with a
+// fresh decoder per operation (lzma_stream_decoder/lzma_end, ZSTD_decompress,
+// BZ2_bzBuffToBuffDecompress, as operations used to be decoded) and once
+// through one DecoderCache, and prints the time per operation of each.
+//
+//   bench_decoder_setup [OP_KB] [OPS]
+
+#include "decoders.hpp"
+
+#include <bzlib.h>
+#include <lzma.h>
+#include <zstd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using payload_dumper::DecoderCache;
+
+namespace
+{
+
+using Blob = std::vector<uint8_t>;
+
+// Text-like data: compresses a few times over, like typical partition content
+Blob makeInput(size_t size)
+{
+    static const char* const words[] = {"system", "vendor", "lib", "so", "xml", "apk",
+                                        "0000", "ffff", "etc", "bin", "odex"};
+    std::mt19937 rng(7);
+    Blob data;
+    while (data.size() < size) {
+        const char* word = words[rng() % (sizeof(words) / sizeof(words[0]))];
+        while (*word && data.size() < size) {
+            data.push_back(static_cast<uint8_t>(*word++));
+        }
+        if (data.size() < size) {
+            data.push_back(static_cast<uint8_t>(rng() % 4 == 0 ? rng() : ' '));
+        }
+    }
+    return data;
+}
+
+Blob compressXz(const Blob& in)
+{
+    Blob out(lzma_stream_buffer_bound(in.size()));
+    size_t out_pos = 0;
+    if (lzma_easy_buffer_encode(6, LZMA_CHECK_CRC64, nullptr, in.data(), in.size(), out.data(),
+                                &out_pos, out.size()) != LZMA_OK) {
+        return {};
+    }
+    out.resize(out_pos);
+    return out;
+}
+
+Blob compressZstd(const Blob& in)
+{
+    Blob out(ZSTD_compressBound(in.size()));
+    size_t size = ZSTD_compress(out.data(), out.size(), in.data(), in.size(), 19);
+    if (ZSTD_isError(size)) {
+        return {};
+    }
+    out.resize(size);
+    return out;
+}
+
+Blob compressBz2(const Blob& in)
+{
+    unsigned int size = static_cast<unsigned int>(in.size() + in.size() / 100 + 600);
+    Blob out(size);
+    if (BZ2_bzBuffToBuffCompress(reinterpret_cast<char*>(out.data()), &size,
+                                 const_cast<char*>(reinterpret_cast<const char*>(in.data())),
+                                 static_cast<unsigned int>(in.size()), 9, 0, 0) != BZ_OK) {
+        return {};
+    }
+    out.resize(size);
+    return out;
+}
+
+bool freshXz(const Blob& in, Blob& out)
+{
+    lzma_stream strm = LZMA_STREAM_INIT;
+    if (lzma_stream_decoder(&strm, UINT64_MAX, 0) != LZMA_OK) {
+        return false;
+    }
+    strm.next_in = in.data();
+    strm.avail_in = in.size();
+    strm.next_out = out.data();
+    strm.avail_out = out.size();
+    lzma_ret ret = lzma_code(&strm, LZMA_FINISH);
+    lzma_end(&strm);
+    return ret == LZMA_STREAM_END;
+}
+
+bool freshZstd(const Blob& in, Blob& out)
+{
+    return !ZSTD_isError(ZSTD_decompress(out.data(), out.size(), in.data(), in.size()));
+}
+
+bool freshBz2(const Blob& in, Blob& out)
+{
+    unsigned int size = static_cast<unsigned int>(out.size());
+    return BZ2_bzBuffToBuffDecompress(reinterpret_cast<char*>(out.data()), &size,
+                                      const_cast<char*>(reinterpret_cast<const char*>(in.data())),
+                                      static_cast<unsigned int>(in.size()), 0, 0) == BZ_OK;
+}
+
+// Microseconds per call of decode(), or -1 if one failed. A few untimed
+// calls first, so neither variant pays for warming the caches.
+template <typename Decode>
+double timePerOp(int ops, Decode decode)
+{
+    for (int i = 0; i < ops / 10 + 1; ++i) {
+        if (!decode()) {
+            return -1.0;
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ops; ++i) {
+        if (!decode()) {
+            return -1.0;
+        }
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ops;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t op_bytes = static_cast<size_t>(argc > 1 ? std::atoi(argv[1]) : 16) * 1024;
+    const int ops = argc > 2 ? std::atoi(argv[2]) : 2000;
+    if (op_bytes == 0 || ops <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [OP_KB] [OPS]\n";
+        return 1;
+    }
+
+    const Blob input = makeInput(op_bytes);
+    const Blob xz = compressXz(input);
+    const Blob zstd = compressZstd(input);
+    const Blob bz2 = compressBz2(input);
+    if (xz.empty() || zstd.empty() || bz2.empty()) {
+        std::cerr << "Failed to compress the test data\n";
+        return 1;
+    }
+
+    Blob out(op_bytes);
+    DecoderCache cache;
+    size_t out_size = 0;
+    auto cachedXz = [&]() {
+        return cache.decodeXz(xz.data(), xz.size(), out.data(), out.size(), &out_size);
+    };
+    auto cachedZstd = [&]() {
+        return cache.decodeZstd(zstd.data(), zstd.size(), out.data(), out.size(), &out_size);
+    };
+    auto cachedBz2 = [&]() {
+        return cache.decodeBz2(bz2.data(), bz2.size(), out.data(), out.size(), &out_size);
+    };
+
+    std::cout << ops << " operation(s) of " << op_bytes / 1024 << " KiB each\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "codec  fresh us/op  cached us/op  saved us/op\n";
+    auto print = [](const char* name, double fresh, double cached) {
+        if (fresh < 0 || cached < 0) {
+            std::cout << std::left << std::setw(7) << name << "decode failed\n" << std::right;
+            return;
+        }
+        std::cout << std::left << std::setw(5) << name << std::right << std::setw(13) << fresh
+                  << std::setw(14) << cached << std::setw(13) << fresh - cached << "\n";
+    };
+    print("xz", timePerOp(ops, [&]() { return freshXz(xz, out); }), timePerOp(ops, cachedXz));
+    print("zstd", timePerOp(ops, [&]() { return freshZstd(zstd, out); }),
+          timePerOp(ops, cachedZstd));
+    print("bz2", timePerOp(ops, [&]() { return freshBz2(bz2, out); }), timePerOp(ops, cachedBz2));
+    std::cout << "DecoderCache set up decoder state " << DecoderCache::setupCount()
+              << " time(s)\n";
+    return 0;
+}
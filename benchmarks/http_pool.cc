@@ -0,0 +1,98 @@
+// Reads blocks of a remote file through the HTTP backend from a growing
+// number of threads and prints the throughput, the curl handles the pool
+// opened and the requests that were in flight at once. Run it against
+// range_server.py, which adds a fixed delay to every request, to see how
+// concurrent range requests hide latency.
+//
+//   bench_http_pool URL [BLOCK_KB] [READS] [MAX_THREADS]
+
+extern "C" {
+#include "ziprand.h"
+#include "http.h"
+}
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " URL [BLOCK_KB] [READS] [MAX_THREADS]\n";
+        return 1;
+    }
+    const char* url = argv[1];
+    const size_t block_size = static_cast<size_t>(argc > 2 ? std::atoi(argv[2]) : 1024) * 1024;
+    const int reads = argc > 3 ? std::atoi(argv[3]) : 128;
+    const int max_threads = argc > 4 ? std::atoi(argv[4]) : 64;
+    if (block_size == 0 || reads <= 0) {
+        std::cerr << "Usage: " << argv[0] << " URL [BLOCK_KB] [READS] [MAX_THREADS]\n";
+        return 1;
+    }
+
+    ziprand_http_config_t config = ziprand_http_config_default();
+    config.verbose = 0;
+
+    std::cout << std::fixed << std::setprecision(1);
+    bool header = false;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        // A fresh backend per run, so its handle and in-flight counts are its own
+        ziprand_io_t* io = ziprand_io_http_ex(url, &config);
+        if (!io) {
+            std::cerr << "Failed to connect to " << url << "\n";
+            return 1;
+        }
+        const int64_t file_size = io->get_size(io->ctx);
+        const uint64_t blocks = file_size > 0 ? static_cast<uint64_t>(file_size) / block_size : 0;
+        if (blocks == 0) {
+            std::cerr << "File is smaller than one block\n";
+            ziprand_io_free(io);
+            return 1;
+        }
+        if (!header) {
+            std::cout << (ziprand_http_is_multiplexed(io) ? "HTTP/2" : "HTTP/1.1") << ", "
+                      << reads << " read(s) of " << block_size / 1024 << " KiB\n";
+            std::cout << "threads     MB/s  handles  peak in flight\n";
+            header = true;
+        }
+
+        std::atomic<int> next{0};
+        std::atomic<bool> failed{false};
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&]() {
+                std::vector<uint8_t> buffer(block_size);
+                for (int i = next++; i < reads; i = next++) {
+                    // Spread over the file, the same offsets in every run
+                    const uint64_t offset = (static_cast<uint64_t>(i) * 7919 % blocks) * block_size;
+                    if (io->read(io->ctx, offset, buffer.data(), block_size) !=
+                        static_cast<int64_t>(block_size)) {
+                        failed = true;
+                        return;
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const int handles = ziprand_http_get_handle_count(io);
+        const int peak = ziprand_http_get_max_in_flight(io);
+        ziprand_io_free(io);
+        if (failed) {
+            std::cerr << "Read failed with " << threads << " thread(s)\n";
+            return 1;
+        }
+        const double megabytes = static_cast<double>(block_size) * reads / (1024 * 1024);
+        std::cout << std::setw(7) << threads << std::setw(9) << megabytes / elapsed.count()
+                  << std::setw(9) << handles << std::setw(16) << peak << "\n";
+    }
+    return 0;
+}
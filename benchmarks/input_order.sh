@@ -0,0 +1,85 @@
+#!/bin/bash
+# Times --order partition against --order input with the payload on a slow
+# device. Without DIR, the payload is put on an ext4 image behind a
+# device-mapper delay target, which holds back every read request by
+# DELAY_MS: scattered reads, which readahead cannot merge, pay it over and
+# over, much like seeks on a spinning disk. With DIR (a mount of a real slow
+# disk) the payload is copied there instead. Page caches are dropped before
+# every run, so this needs root.
+#
+#   input_order.sh PAYLOAD [DELAY_MS | DIR]
+#
+# BIN overrides the binary (default build/payload-dumper-ungo), THREADS the
+# thread counts tried (default "1 4 8").
+set -e
+
+PAYLOAD="$1"
+TARGET="${2:-5}"
+BIN="${BIN:-build/payload-dumper-ungo}"
+THREADS="${THREADS:-1 4 8}"
+
+if [ -z "$PAYLOAD" ] || [ ! -f "$PAYLOAD" ]; then
+    echo "Usage: $0 PAYLOAD [DELAY_MS | DIR]"
+    exit 1
+fi
+if [ ! -x "$BIN" ]; then
+    echo "Error: $BIN not found; build first or set BIN"
+    exit 1
+fi
+if [ "$(id -u)" -ne 0 ]; then
+    echo "Error: needs root to drop page caches (and to set up the delay device)"
+    exit 1
+fi
+
+WORK="$(mktemp -d)"
+LOOP=""
+DM_NAME="pdu-bench-$$"
+MOUNTED=""
+COPY=""
+
+cleanup() {
+    [ -n "$COPY" ] && rm -f "$COPY"
+    [ -n "$MOUNTED" ] && umount "$MOUNTED" || true
+    dmsetup remove "$DM_NAME" 2>/dev/null || true
+    [ -n "$LOOP" ] && losetup -d "$LOOP" || true
+    rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+if [ -d "$TARGET" ]; then
+    COPY="$TARGET/payload-bench-$$.bin"
+    cp "$PAYLOAD" "$COPY"
+    INPUT="$COPY"
+    echo "Payload on $TARGET"
+else
+    # Room for the payload plus filesystem overhead
+    SIZE_MB=$(( $(stat -c %s "$PAYLOAD") / 1048576 * 11 / 10 + 64 ))
+    truncate -s "${SIZE_MB}M" "$WORK/disk.img"
+    mkfs.ext4 -q -F "$WORK/disk.img"
+    LOOP="$(losetup --find --show "$WORK/disk.img")"
+    mkdir "$WORK/mnt"
+    mount "$LOOP" "$WORK/mnt"
+    cp "$PAYLOAD" "$WORK/mnt/payload.bin"
+    umount "$WORK/mnt"
+
+    SECTORS="$(blockdev --getsz "$LOOP")"
+    echo "0 $SECTORS delay $LOOP 0 $TARGET" | dmsetup create "$DM_NAME"
+    mount -o ro "/dev/mapper/$DM_NAME" "$WORK/mnt"
+    MOUNTED="$WORK/mnt"
+    INPUT="$WORK/mnt/payload.bin"
+    echo "Payload behind a ${TARGET} ms delay per read request"
+fi
+
+printf "%-10s %8s %10s\n" "order" "threads" "seconds"
+for threads in $THREADS; do
+    for order in partition input; do
+        rm -rf "$WORK/out"
+        sync
+        echo 3 > /proc/sys/vm/drop_caches
+        start=$(date +%s.%N)
+        "$BIN" --order "$order" -c "$threads" -o "$WORK/out" "$INPUT" > /dev/null
+        end=$(date +%s.%N)
+        awk -v o="$order" -v t="$threads" -v s="$start" -v e="$end" \
+            'BEGIN { printf "%-10s %8s %10.2f\n", o, t, e - s }'
+    done
+done
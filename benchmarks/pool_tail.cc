@@ -0,0 +1,147 @@
+// Runs the same skewed set of partitions two ways and reports how long the
+// threads sat idle at the end: one task per partition taken from a mutex
+// guarded FIFO queue (how partitions used to be handed out), and batches of
+// operations sorted largest partition first on the WorkStealingPool. Every
+// unit of work hashes a buffer, standing in for decoding one operation.
+//
+//   bench_pool_tail [THREADS] [UNIT_KB]
+
+#include "sha256.h"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using payload_dumper::WorkStealingPool;
+
+namespace
+{
+
+struct Partition {
+    const char* name;
+    int units;
+};
+
+// Sizes in units, roughly the shape of a full OTA: one image dwarfs the rest
+const Partition PARTITIONS[] = {
+    {"boot", 32},        {"dtbo", 8},         {"odm", 16},    {"product", 160},
+    {"system", 512},     {"system_ext", 96},  {"vbmeta", 1},  {"vbmeta_system", 1},
+    {"vendor", 192},     {"vendor_boot", 32}, {"vendor_dlkm", 16},
+};
+// Units per batch, as OPERATION_BATCH_BYTES cuts a partition
+const int BATCH_UNITS = 32;
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    double wall_ms;
+    double tail_idle_ms;
+};
+
+void work(std::vector<uint8_t>& buffer, int units)
+{
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    for (int i = 0; i < units; ++i) {
+        sha256(buffer.data(), buffer.size(), digest);
+        buffer[0] = digest[0];
+    }
+}
+
+Result runFifo(int threads, size_t unit_bytes)
+{
+    std::queue<const Partition*> queue;
+    for (const auto& partition : PARTITIONS) {
+        queue.push(&partition);
+    }
+    std::mutex queue_mutex;
+    std::vector<Clock::time_point> finished(threads);
+    auto start = Clock::now();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            std::vector<uint8_t> buffer(unit_bytes, static_cast<uint8_t>(t));
+            while (true) {
+                const Partition* partition = nullptr;
+                {
+                    std::lock_guard<std::mutex> lock(queue_mutex);
+                    if (queue.empty()) {
+                        break;
+                    }
+                    partition = queue.front();
+                    queue.pop();
+                }
+                work(buffer, partition->units);
+            }
+            finished[t] = Clock::now();
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    auto last = *std::max_element(finished.begin(), finished.end());
+    Result result{std::chrono::duration<double, std::milli>(last - start).count(), 0.0};
+    for (const auto& t : finished) {
+        result.tail_idle_ms += std::chrono::duration<double, std::milli>(last - t).count();
+    }
+    return result;
+}
+
+Result runPool(int threads, size_t unit_bytes)
+{
+    std::vector<const Partition*> order;
+    for (const auto& partition : PARTITIONS) {
+        order.push_back(&partition);
+    }
+    std::stable_sort(order.begin(), order.end(), [](const Partition* a, const Partition* b) {
+        return a->units > b->units;
+    });
+
+    std::vector<std::vector<uint8_t>> buffers(threads, std::vector<uint8_t>(unit_bytes));
+    std::vector<WorkStealingPool::Task> tasks;
+    for (const Partition* partition : order) {
+        for (int begin = 0; begin < partition->units; begin += BATCH_UNITS) {
+            const int units = std::min(BATCH_UNITS, partition->units - begin);
+            tasks.push_back([&buffers, units](int thread_index) {
+                work(buffers[thread_index], units);
+            });
+        }
+    }
+
+    WorkStealingPool pool(threads);
+    pool.run(std::move(tasks));
+    return {pool.stats().wall_ms, pool.stats().tail_idle_ms};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int threads =
+        argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+    const size_t unit_bytes = static_cast<size_t>(argc > 2 ? std::atoi(argv[2]) : 1024) * 1024;
+    if (threads <= 0 || unit_bytes == 0) {
+        std::cerr << "Usage: " << argv[0] << " [THREADS] [UNIT_KB]\n";
+        return 1;
+    }
+
+    std::cout << "SHA-256: " << sha256_implementation() << ", " << threads << " thread(s)\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "schedule                 wall ms  tail idle ms  idle %\n";
+    auto print = [threads](const char* name, const Result& result) {
+        std::cout << std::left << std::setw(21) << name << std::right << std::setw(11)
+                  << result.wall_ms << std::setw(14) << result.tail_idle_ms << std::setw(8)
+                  << 100.0 * result.tail_idle_ms / (result.wall_ms * threads) << "\n";
+    };
+    print("FIFO partitions", runFifo(threads, unit_bytes));
+    print("work-stealing batches", runPool(threads, unit_bytes));
+    return 0;
+}
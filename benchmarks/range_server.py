@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Serves one file over HTTP/1.1 with Range support and a fixed delay before
+every response body, standing in for a distant server in bench_http_pool.
+
+    range_server.py FILE [--port 8080] [--delay-ms 50]
+"""
+
+import argparse
+import http.server
+import os
+import re
+import time
+
+
+def make_handler(path, delay):
+    size = os.path.getsize(path)
+
+    class RangeHandler(http.server.BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def log_message(self, *args):
+            pass
+
+        def reply(self, with_body):
+            first, last = 0, size - 1
+            match = re.match(r"bytes=(\d+)-(\d*)$", self.headers.get("Range", ""))
+            if match:
+                first = int(match[1])
+                if match[2]:
+                    last = min(int(match[2]), size - 1)
+                if first > last:
+                    self.send_response(416)
+                    self.send_header("Content-Range", f"bytes */{size}")
+                    self.send_header("Content-Length", "0")
+                    self.end_headers()
+                    return
+                self.send_response(206)
+                self.send_header("Content-Range", f"bytes {first}-{last}/{size}")
+            else:
+                self.send_response(200)
+            self.send_header("Content-Length", str(last - first + 1))
+            self.send_header("Accept-Ranges", "bytes")
+            self.end_headers()
+            if not with_body:
+                return
+            time.sleep(delay)
+            with open(path, "rb") as f:
+                f.seek(first)
+                self.wfile.write(f.read(last - first + 1))
+
+        def do_HEAD(self):
+            self.reply(False)
+
+        def do_GET(self):
+            self.reply(True)
+
+    return RangeHandler
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("file")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--delay-ms", type=float, default=50.0)
+    args = parser.parse_args()
+
+    http.server.ThreadingHTTPServer.request_queue_size = 128
+    server = http.server.ThreadingHTTPServer(
+        ("127.0.0.1", args.port), make_handler(args.file, args.delay_ms / 1000.0))
+    print(f"Serving {args.file} on http://127.0.0.1:{args.port}/ "
+          f"with {args.delay_ms:g} ms delay")
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
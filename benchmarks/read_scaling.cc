@@ -0,0 +1,107 @@
+// Reads a file in fixed-size blocks, in a shuffled order like operation blobs
+// spread over a payload, from 1 up to 64 threads. Each thread count runs once
+// through a std::ifstream shared under a mutex (how payload.bin used to be
+// read) and once through PositionalFile::readAt().
+//
+//   bench_read_scaling FILE [BLOCK_KB] [MAX_THREADS]
+
+#include "file_io.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+using payload_dumper::PositionalFile;
+
+// Fans the block list out over threads; read() returns false on a failed read
+template <typename Read>
+static double run(int threads, const std::vector<int64_t>& blocks, int64_t block_size, Read read)
+{
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            std::vector<char> buffer(static_cast<size_t>(block_size));
+            for (size_t i = next++; i < blocks.size(); i = next++) {
+                if (!read(buffer.data(), blocks[i] * block_size, block_size)) {
+                    failed = true;
+                    return;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return failed ? -1.0 : elapsed.count();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " FILE [BLOCK_KB] [MAX_THREADS]\n";
+        return 1;
+    }
+    const std::string path = argv[1];
+    const int64_t block_size = (argc > 2 ? std::atoll(argv[2]) : 256) * 1024;
+    const int max_threads = argc > 3 ? std::atoi(argv[3]) : 64;
+
+    PositionalFile file;
+    if (block_size <= 0 || !file.open(path)) {
+        std::cerr << "Failed to open " << path << "\n";
+        return 1;
+    }
+    std::ifstream stream(path, std::ios::binary);
+    std::mutex stream_mutex;
+
+    // Whole blocks only, so every read is the same size
+    std::vector<int64_t> blocks(static_cast<size_t>(file.size() / block_size));
+    if (blocks.empty()) {
+        std::cerr << "File is smaller than one block\n";
+        return 1;
+    }
+    std::iota(blocks.begin(), blocks.end(), 0);
+    std::shuffle(blocks.begin(), blocks.end(), std::mt19937(1));
+    const double megabytes = static_cast<double>(blocks.size() * block_size) / (1024 * 1024);
+
+    auto streamRead = [&](char* buffer, int64_t offset, int64_t length) {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        stream.seekg(offset);
+        return static_cast<bool>(stream.read(buffer, length));
+    };
+    auto positionalRead = [&](char* buffer, int64_t offset, int64_t length) {
+        return file.readAt(buffer, offset, length) == length;
+    };
+
+    // Pulls the file into the page cache, so the runs compare the read paths
+    // rather than whichever came first
+    run(1, blocks, block_size, positionalRead);
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "threads  ifstream+mutex MB/s  pread MB/s\n";
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        double locked = run(threads, blocks, block_size, streamRead);
+        double positional = run(threads, blocks, block_size, positionalRead);
+        if (locked <= 0 || positional <= 0) {
+            std::cerr << "Read failed\n";
+            return 1;
+        }
+        std::cout << std::setw(7) << threads << std::setw(21) << megabytes / locked
+                  << std::setw(12) << megabytes / positional << "\n";
+    }
+    return 0;
+}
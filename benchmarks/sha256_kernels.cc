@@ -0,0 +1,120 @@
+// Hashes one buffer with every SHA-256 block implementation this CPU can
+// run and prints each one's throughput, so the kernel that sha256_select()
+// picks can be compared with the others. The 8-lane AVX2 kernel hashes eight
+// independent messages at once and is measured over eight slices instead.
+//
+//   bench_sha256_kernels [MB] [REPEATS]
+
+#include "sha256.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+const uint32_t INITIAL_STATE[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+// Best of repeats, in seconds; the fastest run is the least disturbed one
+template <typename Hash>
+double bestTime(int repeats, Hash hash)
+{
+    double best = 0.0;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        hash();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t megabytes = static_cast<size_t>(argc > 1 ? std::atoi(argv[1]) : 256);
+    const int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (megabytes == 0 || repeats <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [MB] [REPEATS]\n";
+        return 1;
+    }
+
+    std::vector<uint8_t> buffer(megabytes * 1024 * 1024);
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        buffer[i] = static_cast<uint8_t>(i * 2654435761u >> 13);
+    }
+    const size_t blocks = buffer.size() / SHA256_BLOCK_SIZE;
+    const double gigabytes = static_cast<double>(buffer.size()) / 1e9;
+
+    struct Kernel {
+        const char* name;
+        sha256_blocks_fn blocks;
+    };
+    std::vector<Kernel> kernels = {{"scalar", sha256_blocks_scalar}};
+#ifdef SHA256_HAVE_SHANI
+    if (sha256_cpu_has_shani()) {
+        kernels.push_back({"sha-ni", sha256_blocks_shani});
+    }
+#endif
+#ifdef SHA256_HAVE_ARMV8
+    if (sha256_cpu_has_armv8()) {
+        kernels.push_back({"armv8-crypto", sha256_blocks_armv8});
+    }
+#endif
+
+    std::cout << "Selected: " << sha256_implementation() << ", " << megabytes << " MB, best of "
+              << repeats << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "kernel          GB/s  matches scalar\n";
+
+    uint32_t reference[8];
+    for (const auto& kernel : kernels) {
+        uint32_t state[8];
+        double seconds = bestTime(repeats, [&]() {
+            memcpy(state, INITIAL_STATE, sizeof(state));
+            kernel.blocks(state, buffer.data(), blocks);
+        });
+        if (kernel.blocks == sha256_blocks_scalar) {
+            memcpy(reference, state, sizeof(reference));
+        }
+        std::cout << std::left << std::setw(12) << kernel.name << std::right << std::setw(8)
+                  << gigabytes / seconds << "  "
+                  << (memcmp(state, reference, sizeof(state)) == 0 ? "yes" : "NO") << "\n";
+    }
+
+#ifdef SHA256_HAVE_AVX2
+    if (sha256_cpu_has_avx2()) {
+        const size_t slice = buffer.size() / SHA256_X8_LANES;
+        const uint8_t* data[SHA256_X8_LANES];
+        size_t lens[SHA256_X8_LANES];
+        for (size_t i = 0; i < SHA256_X8_LANES; ++i) {
+            data[i] = buffer.data() + i * slice;
+            lens[i] = slice;
+        }
+        uint8_t lanes[SHA256_X8_LANES][SHA256_DIGEST_SIZE];
+        double seconds = bestTime(repeats, [&]() {
+            sha256_many_x8(data, lens, SHA256_X8_LANES, lanes);
+        });
+
+        bool same = true;
+        for (size_t i = 0; i < SHA256_X8_LANES; ++i) {
+            uint8_t digest[SHA256_DIGEST_SIZE];
+            sha256(data[i], lens[i], digest);
+            same = same && memcmp(digest, lanes[i], SHA256_DIGEST_SIZE) == 0;
+        }
+        std::cout << std::left << std::setw(12) << "avx2 x8" << std::right << std::setw(8)
+                  << gigabytes / seconds << "  " << (same ? "yes" : "NO")
+                  << " (8 messages at once, checked with sha256())\n";
+    }
+#endif
+    return 0;
+}
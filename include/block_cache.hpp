@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace payload_dumper
+{
+
+// Persistent read-through cache of a remote file in fixed-size blocks. Each
+// block is a file in the cache directory named by the SHA-256 of the key (URL
+// and validator of one version of one file) and the block index, so any
+// number of files share the directory and its size cap. The least recently
+// used blocks are evicted first; file modification times carry that order
+// across runs. read() may be called from any number of threads at once.
+class BlockCache
+{
+  public:
+    // Reads the origin; same contract as PositionalFile::readAt()
+    using Fetch = std::function<int64_t(void* buffer, uint64_t offset, size_t length)>;
+
+    explicit BlockCache(Fetch fetch);
+
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    // Creates dir if needed and indexes the blocks already in it
+    bool open(const std::string& dir,
+              const std::string& key,
+              uint64_t file_size,
+              uint64_t max_bytes);
+
+    // Same contract as PositionalFile::readAt(). Blocks that are not cached
+    // are fetched whole, adjacent ones in a single request, and stored.
+    int64_t read(void* buffer, uint64_t offset, size_t length);
+
+    uint64_t size() const;
+    // Bytes of reads served from the cache, and fetched because they were not
+    uint64_t hitBytes() const;
+    uint64_t missBytes() const;
+
+  private:
+    struct Entry {
+        uint64_t size;
+        std::list<std::string>::iterator lru;
+    };
+
+    Fetch fetch_;
+    std::string dir_;
+    std::string key_;
+    uint64_t file_size_;
+    uint64_t max_bytes_;
+
+    std::mutex mutex_;
+    std::condition_variable loaded_cv_;
+    std::list<std::string> lru_; // block file names, most recently used first
+    std::unordered_map<std::string, Entry> entries_;
+    std::unordered_set<uint64_t> loading_; // blocks of key_ being fetched
+    uint64_t total_bytes_;
+
+    std::atomic<uint64_t> hit_bytes_;
+    std::atomic<uint64_t> miss_bytes_;
+    std::atomic<bool> store_failed_;
+
+    std::string blockName(uint64_t index) const;
+    uint64_t blockSize(uint64_t index) const;
+    bool loadBlock(const std::string& name,
+                   uint64_t block_size,
+                   uint8_t* out,
+                   uint64_t offset,
+                   uint64_t length);
+    void storeBlock(uint64_t index, const uint8_t* data);
+    void evict();
+};
+
+} // namespace payload_dumper
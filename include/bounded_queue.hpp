@@ -0,0 +1,219 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace payload_dumper
+{
+
+// Bounded multi-producer/multi-consumer queue (Vyukov's array queue): every
+// cell carries a sequence number, so push and pop are a single CAS each and
+// never take a lock. The blocking variants spin briefly by yielding, then
+// park on a condition variable that the other side only signals while
+// somebody is parked, so the fast path stays lock-free.
+template <typename T> class BoundedQueue
+{
+  public:
+    explicit BoundedQueue(size_t capacity)
+        : capacity_(roundUp(capacity)), mask_(capacity_ - 1), cells_(new Cell[capacity_]),
+          enqueue_pos_(0), dequeue_pos_(0), closed_(false), push_waiters_(0), pop_waiters_(0),
+          occupancy_total_(0), occupancy_samples_(0)
+    {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    size_t sizeApprox() const
+    {
+        size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+        size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool tryPush(T& value)
+    {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        occupancy_total_.fetch_add(sizeApprox(), std::memory_order_relaxed);
+        occupancy_samples_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool tryPop(T& value)
+    {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->data);
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Blocks while the queue is full
+    void push(T value)
+    {
+        for (unsigned spins = 0; spins < SPIN_LIMIT; ++spins) {
+            if (tryPush(value)) {
+                wake(pop_waiters_, not_empty_);
+                return;
+            }
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        park(push_waiters_);
+        while (!tryPush(value)) {
+            not_full_.wait(lock);
+        }
+        push_waiters_.fetch_sub(1);
+        lock.unlock();
+        wake(pop_waiters_, not_empty_);
+    }
+
+    // Blocks while the queue is empty; returns false once it is closed and drained
+    bool pop(T& value)
+    {
+        for (unsigned spins = 0; spins < SPIN_LIMIT; ++spins) {
+            if (tryPop(value)) {
+                wake(push_waiters_, not_full_);
+                return true;
+            }
+            if (closed_.load(std::memory_order_acquire)) {
+                // A push may have landed between the failed pop and the check
+                return tryPop(value);
+            }
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        park(pop_waiters_);
+        bool popped;
+        while (!(popped = tryPop(value)) && !closed_.load(std::memory_order_acquire)) {
+            not_empty_.wait(lock);
+        }
+        if (!popped) {
+            popped = tryPop(value);
+        }
+        pop_waiters_.fetch_sub(1);
+        lock.unlock();
+        if (popped) {
+            wake(push_waiters_, not_full_);
+        }
+        return popped;
+    }
+
+    // No more pushes will follow; consumers drain what is left and stop
+    void close()
+    {
+        closed_.store(true, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(mutex_);
+        not_empty_.notify_all();
+    }
+
+    // Average number of queued items seen right after each push
+    double averageOccupancy() const
+    {
+        uint64_t samples = occupancy_samples_.load(std::memory_order_relaxed);
+        return samples ? static_cast<double>(occupancy_total_.load(std::memory_order_relaxed)) /
+                             samples
+                       : 0.0;
+    }
+
+  private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    static size_t roundUp(size_t n)
+    {
+        size_t size = 2;
+        while (size < n) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    // Yields before a blocking call parks its thread
+    static constexpr unsigned SPIN_LIMIT = 64;
+
+    // Registers a waiter before its final attempt. The fences here and in
+    // wake() order the waiter count against the cell sequence, so either the
+    // waiter sees the item or the other side sees the waiter.
+    static void park(std::atomic<int>& waiters)
+    {
+        waiters.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void wake(std::atomic<int>& waiters, std::condition_variable& cv)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv.notify_one();
+        }
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> enqueue_pos_;
+    alignas(64) std::atomic<size_t> dequeue_pos_;
+    std::atomic<bool> closed_;
+
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::atomic<int> push_waiters_;
+    std::atomic<int> pop_waiters_;
+
+    std::atomic<uint64_t> occupancy_total_;
+    std::atomic<uint64_t> occupancy_samples_;
+};
+
+} // namespace payload_dumper
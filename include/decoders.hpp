@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace payload_dumper
+{
+
+// Decompressor state kept alive across operations, one per extraction thread.
+// The ZSTD context and the XZ stream are reset rather than recreated, and
+// bzip2 (which has no reset) allocates from a per-thread allocation pool, so the
+// per-operation cost is no longer dominated by setting up decoder state.
+class DecoderCache
+{
+  public:
+    DecoderCache();
+    ~DecoderCache();
+
+    DecoderCache(const DecoderCache&) = delete;
+    DecoderCache& operator=(const DecoderCache&) = delete;
+
+    // Each decodes one complete stream into out and stores the number of bytes
+    // produced in *out_size. Returns false on init failure or corrupt input.
+    bool decodeXz(const uint8_t* in,
+                  size_t in_size,
+                  uint8_t* out,
+                  size_t out_capacity,
+                  size_t* out_size);
+    bool decodeBz2(const uint8_t* in,
+                   size_t in_size,
+                   uint8_t* out,
+                   size_t out_capacity,
+                   size_t* out_size);
+    bool decodeZstd(const uint8_t* in,
+                    size_t in_size,
+                    uint8_t* out,
+                    size_t out_capacity,
+                    size_t* out_size);
+
+    // Process-wide count of decoder state allocations, for --stats
+    static uint64_t setupCount();
+
+  private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
+} // namespace payload_dumper
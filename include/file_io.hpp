@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace payload_dumper
+{
+
+// Read-only file accessed purely by offset. There is no shared file position,
+// so readAt() may be called from any number of threads at once.
+class PositionalFile
+{
+  public:
+    PositionalFile();
+    ~PositionalFile();
+
+    PositionalFile(const PositionalFile&) = delete;
+    PositionalFile& operator=(const PositionalFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+    int64_t size() const;
+    // Underlying descriptor for async I/O; -1 on Windows or when closed
+    int fd() const;
+
+    // Returns the number of bytes read (short only at EOF), or -1 on error.
+    int64_t readAt(void* buffer, int64_t offset, int64_t length) const;
+
+    // Maps the whole file read-only. data() stays valid until close().
+    bool map();
+    const uint8_t* data() const;
+
+    // Page cache hints for the mapping; no-ops when unmapped or unsupported.
+    void adviseSequential() const;
+    void adviseWillNeed(int64_t offset, int64_t length) const;
+
+  private:
+#ifdef _WIN32
+    void* handle_;
+    void* mapping_;
+#else
+    int fd_;
+#endif
+    int64_t size_;
+    uint8_t* map_;
+};
+
+// Input that can only be read front to back, such as standard input or a
+// pipe. readAt() accepts any offset at or past the bytes consumed so far and
+// discards whatever lies in between. Not safe for concurrent use.
+class StreamFile
+{
+  public:
+    StreamFile();
+    ~StreamFile();
+
+    StreamFile(const StreamFile&) = delete;
+    StreamFile& operator=(const StreamFile&) = delete;
+
+    // "-" reads standard input
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+    // Number of bytes consumed from the stream so far
+    int64_t position() const;
+
+    // Same contract as PositionalFile::readAt(); an offset that the stream
+    // has already passed is an error.
+    int64_t readAt(void* buffer, int64_t offset, int64_t length);
+
+    // True for "-" and for paths naming a FIFO, socket or character device
+    static bool isStream(const std::string& path);
+
+  private:
+    int64_t read(void* buffer, int64_t length);
+
+#ifdef _WIN32
+    void* handle_;
+#else
+    int fd_;
+#endif
+    bool owned_;
+    int64_t position_;
+};
+
+// How OutputFile::copyRange() moved the data
+enum class CopyPath {
+    None, // nothing was copied; the caller has to go through memory
+    Clone,
+    CopyFileRange,
+};
+
+// One buffer of a vectored write
+struct WriteSegment {
+    const void* data;
+    size_t size;
+};
+
+// Output file for partition images. writeAt() is positional, so disjoint
+// extents of one image can be written from several threads at once. It is
+// opened read-write so finished regions can be read back for hashing.
+class OutputFile
+{
+  public:
+    OutputFile();
+    ~OutputFile();
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    // Creates the file, truncating an existing one unless truncate is false
+    bool open(const std::string& path, bool truncate = true);
+    bool close();
+    bool isOpen() const;
+    int fd() const;
+
+    // Writes all of data or fails
+    bool writeAt(const void* data, size_t size, int64_t offset) const;
+    // Writes the segments back to back starting at offset, with pwritev where
+    // available so a run of adjacent buffers costs a single syscall
+    bool writeAt(const WriteSegment* segments, size_t count, int64_t offset) const;
+    // Same contract as PositionalFile::readAt()
+    int64_t readAt(void* buffer, int64_t offset, int64_t length) const;
+
+    // Makes a range read as zeros without writing them where the filesystem
+    // allows: a hole when sparse, otherwise allocated but unwritten space.
+    // Falls back to writing zeros.
+    bool zeroRange(int64_t offset, int64_t length, bool sparse) const;
+    // Grows the file to size if it is shorter; the new tail reads as zeros
+    bool extendTo(int64_t size) const;
+    // Reserves size bytes up front so the filesystem can lay the image out in
+    // few extents. Returns false where this is unsupported; nothing is written.
+    bool preallocate(int64_t size) const;
+    // Number of extents the filesystem mapped for the file, -1 if unknown
+    int64_t extentCount() const;
+    // Copies length bytes of input at in_offset to offset without passing them
+    // through user space: a reflink when all of it is block aligned and the
+    // filesystem shares extents, otherwise copy_file_range(). Returns
+    // CopyPath::None when the kernel cannot do either for these files.
+    CopyPath copyRange(const PositionalFile& input,
+                       int64_t in_offset,
+                       int64_t length,
+                       int64_t offset) const;
+
+    // Flushes the file's data to stable storage
+    bool sync() const;
+    // Syncs on its own after every interval bytes written; 0 (the default)
+    // leaves it to the caller
+    void setSyncInterval(uint64_t interval);
+    // Accounts for bytes written to fd() without going through this object,
+    // e.g. by io_uring, so periodic syncs still see them
+    bool addWritten(uint64_t bytes) const;
+    // System calls that modified the file, and how many of them were syncs
+    uint64_t syscallCount() const;
+    uint64_t syncCount() const;
+
+  private:
+#ifdef _WIN32
+    void* handle_;
+#else
+    int fd_;
+#endif
+    uint64_t sync_interval_;
+    mutable std::atomic<uint64_t> unsynced_;
+    mutable std::atomic<uint64_t> syscalls_;
+    mutable std::atomic<uint64_t> syncs_;
+};
+
+} // namespace payload_dumper
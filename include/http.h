@@ -1,6 +1,7 @@
 #ifndef ZIPRAND_HTTP_H
 #define ZIPRAND_HTTP_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <ziprand.h>
 
@@ -47,6 +48,35 @@ ziprand_io_t* ziprand_io_http(const char* url);
  */
 uint64_t ziprand_http_get_bytes_downloaded(ziprand_io_t* io);
 
+/**
+ * Get the number of curl handles open for concurrent range requests
+ * @param io HTTP I/O interface
+ * @return Handles created so far and not yet freed, or 0 if not HTTP
+ */
+int ziprand_http_get_handle_count(ziprand_io_t* io);
+
+/**
+ * Get the largest number of range requests that were in flight at once
+ * @param io HTTP I/O interface
+ * @return Peak outstanding requests, or 0 if not HTTP
+ */
+int ziprand_http_get_max_in_flight(ziprand_io_t* io);
+
+/**
+ * Get what identifies the current version of the remote file: its strong
+ * ETag, or else its Last-Modified date, as sent in reply to the probe
+ * @param io HTTP I/O interface
+ * @return The header value (owned by io), or NULL if there is none or not HTTP
+ */
+const char* ziprand_http_get_validator(ziprand_io_t* io);
+
+/**
+ * Check whether requests are multiplexed over HTTP/2
+ * @param io HTTP I/O interface
+ * @return 1 for HTTP/2, 0 for HTTP/1.x or if not HTTP
+ */
+int ziprand_http_is_multiplexed(ziprand_io_t* io);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace payload_dumper
+{
+
+// Minimal io_uring submission/completion ring driven through the raw syscalls,
+// so it needs neither liburing nor a kernel newer than the build host. Only
+// positional reads and writes are supported. Not thread-safe: one ring per thread.
+class IoRing
+{
+  public:
+    struct Completion {
+        uint64_t user_data;
+        int32_t result; // bytes transferred, or -errno
+    };
+
+    IoRing();
+    ~IoRing();
+
+    IoRing(const IoRing&) = delete;
+    IoRing& operator=(const IoRing&) = delete;
+
+    // True when the running kernel accepts io_uring with READ/WRITE opcodes
+    static bool supported();
+
+    bool init(unsigned entries);
+    unsigned capacity() const;
+    unsigned inFlight() const;
+
+    // Queue a request; it is handed to the kernel on the next submit() or wait()
+    bool queueRead(int fd, void* buffer, uint32_t length, uint64_t offset, uint64_t user_data);
+    bool queueWrite(int fd,
+                    const void* buffer,
+                    uint32_t length,
+                    uint64_t offset,
+                    uint64_t user_data);
+
+    bool submit();
+    // Blocks until one request completes
+    bool wait(Completion& completion);
+
+    // Queue depth observed at each submit, for reporting
+    uint64_t depthSamples() const;
+    uint64_t depthTotal() const;
+    unsigned depthMax() const;
+
+  private:
+    int ring_fd_;
+    unsigned entries_;
+    unsigned queued_;
+    unsigned in_flight_;
+
+    void* sq_ptr_;
+    size_t sq_size_;
+    void* cq_ptr_;
+    size_t cq_size_;
+    void* sqes_;
+    size_t sqes_size_;
+
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_mask_;
+    unsigned* sq_array_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    void* cqes_;
+
+    uint64_t depth_samples_;
+    uint64_t depth_total_;
+    unsigned depth_max_;
+
+    bool queue(uint8_t opcode,
+               int fd,
+               const void* buffer,
+               uint32_t length,
+               uint64_t offset,
+               uint64_t user_data);
+    int enter(unsigned to_submit, unsigned min_complete);
+    void release();
+};
+
+} // namespace payload_dumper
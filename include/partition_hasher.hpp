@@ -0,0 +1,62 @@
+#pragma once
+
+#include "file_io.hpp"
+#include "sha256.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace payload_dumper
+{
+
+// SHA-256 of a whole partition image, computed while it is being written.
+// Operations finish in any order, so completed ranges are tracked and the
+// hash advances over the longest finished prefix: a range that lands exactly
+// at the frontier is hashed from memory. Ranges finished ahead of it are
+// copied and hashed once the frontier reaches them, as long as the copies fit
+// in the hold budget; the rest are read back from the (still cached) output.
+class PartitionHasher
+{
+  public:
+    PartitionHasher(const OutputFile& output, uint64_t image_size, uint64_t hold_budget);
+
+    PartitionHasher(const PartitionHasher&) = delete;
+    PartitionHasher& operator=(const PartitionHasher&) = delete;
+
+    // [offset, offset + length) of the image now holds its final contents,
+    // which are also available at data (null: the range reads as zeros).
+    // Safe to call from any thread.
+    bool complete(uint64_t offset, const uint8_t* data, uint64_t length);
+
+    // Hashes whatever the operations did not cover (read back, zero past the
+    // end of the file) and produces the digest of the full image
+    bool finish(uint8_t digest[SHA256_DIGEST_SIZE]);
+
+    uint64_t readBackBytes() const;
+
+  private:
+    // Finished range beyond the frontier
+    struct Pending {
+        uint64_t length;
+        bool zeros;
+        std::unique_ptr<uint8_t[]> copy; // null when it has to be read back
+    };
+
+    const OutputFile& output_;
+    const uint64_t image_size_;
+    const uint64_t hold_budget_;
+    std::mutex mutex_;
+    SHA256_CTX ctx_;
+    uint64_t frontier_;
+    uint64_t read_back_;
+    uint64_t held_bytes_; // in the copies of pending_
+    std::map<uint64_t, Pending> pending_;
+
+    void drop(std::map<uint64_t, Pending>::iterator it);
+    bool hashFromFile(uint64_t end);
+    void hashZeros(uint64_t length);
+};
+
+} // namespace payload_dumper
@@ -1,6 +1,7 @@
 #pragma once
+#include "file_io.hpp"
 #include "update_metadata.pb.h"
-#include <fstream>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -24,12 +25,52 @@ extern "C" {
 namespace payload_dumper
 {
 
-// Forward declaration
+// Forward declarations
+class BlockCache;
+class DecoderCache;
+class IoRing;
 class ProgressTracker;
+class RangePrefetcher;
+class RemoteMirror;
+class ScratchBuffer;
 
 constexpr const char* PAYLOAD_MAGIC = "CrAU";
 constexpr uint64_t BRILLO_MAJOR_VERSION = 2;
 constexpr uint64_t BLOCK_SIZE = 4096;
+constexpr uint64_t SYNC_INTERVAL_BYTES = 64ull * 1024 * 1024;
+constexpr uint64_t PREFETCH_BUDGET_BYTES = 256ull * 1024 * 1024;
+constexpr uint64_t CACHE_SIZE_BYTES = 4096ull * 1024 * 1024;
+
+enum class IoEngine {
+    Sync,
+    IoUring,
+};
+
+// Order in which operations are handed to the extraction threads
+enum class ExtractOrder {
+    Partition, // largest partition first, each partition's operations together
+    Input,     // every selected operation by its data offset in payload.bin
+};
+
+// When the images are flushed to stable storage
+enum class SyncMode {
+    None,     // left to the kernel's writeback
+    End,      // once per image after its last write
+    Periodic, // every SYNC_INTERVAL_BYTES written to an image, and at the end
+};
+
+// Staged read -> decode -> write extraction with dedicated threads per stage
+struct PipelineConfig {
+    int readers = 0;
+    int workers = 0;
+    int writers = 0;
+    int queue_depth = 0; // items between stages; 0 = twice the decode workers
+
+    bool enabled() const
+    {
+        return readers > 0;
+    }
+};
 
 struct PayloadHeader {
     uint64_t version;
@@ -54,7 +95,30 @@ class Payload
                          int concurrency);
     void listPartitions() const;
 
+    // Serve raw payload.bin reads straight from a read-only mapping
+    void setUseMmap(bool use_mmap);
+    // io_uring falls back to Sync when the kernel or the input does not support it
+    void setIoEngine(IoEngine engine);
+    // Print scheduler and I/O statistics after extraction
+    void setShowStats(bool show_stats);
+    // Leave zeroed regions and all-zero data blocks of the images as holes
+    void setSparse(bool sparse);
+    // Reserve each image's full size before writing it (not in sparse mode)
+    void setPreallocate(bool preallocate);
+    void setOrder(ExtractOrder order);
+    void setSyncMode(SyncMode mode);
+    // Memory for remote data fetched ahead of the decoders; 0 disables prefetching
+    void setPrefetchBudget(uint64_t bytes);
+    void setPipeline(const PipelineConfig& config);
+
 #ifdef HTTP_SUPPORT
+    // Keep remote data in dir across runs, up to max_bytes; empty disables it
+    void setCache(const std::string& dir, uint64_t max_bytes);
+    // Keep a local copy of the remote file at path, resuming an earlier one;
+    // with complete set the rest of it is fetched in the background
+    void setMirror(const std::string& path, bool complete);
+    // Waits for the local copy to be completed, if requested, and closes it
+    bool finishMirror();
     uint64_t getBytesDownloaded() const;
 #endif
 
@@ -64,14 +128,31 @@ class Payload
     bool verify_hash_;
     bool is_zip_;
     bool is_http_;
+    // Standard input or a pipe, read once from front to back
+    bool is_stream_;
+    bool use_mmap_;
+    IoEngine io_engine_;
 
 #ifdef ENABLE_ZIP
     ziprand_io_t* zip_io_;
     ziprand_archive_t* zip_archive_;
     ziprand_file_t* zip_file_;
 #endif
+#ifdef HTTP_SUPPORT
+    std::string cache_dir_;
+    uint64_t cache_max_bytes_;
+    // Sits between the ZIP reader and the HTTP io when enabled
+    std::unique_ptr<BlockCache> cache_;
+    ziprand_io_t cache_io_;
+    std::string mirror_path_;
+    bool mirror_complete_;
+    // Sits on top of the cache when enabled
+    std::unique_ptr<RemoteMirror> mirror_;
+    ziprand_io_t mirror_io_;
+#endif
 
-    std::ifstream file_;
+    PositionalFile file_;
+    StreamFile stream_;
     PayloadHeader header_;
     chromeos_update_engine::DeltaArchiveManifest manifest_;
     chromeos_update_engine::Signatures signatures_;
@@ -80,16 +161,65 @@ class Payload
     int64_t data_offset_;
     bool initialized_;
 
+    // Only local ZIP archives and streams have a shared position; raw files
+    // use positional reads and HTTP reads each take a pooled connection
     std::mutex file_mutex_;
 
+    bool show_stats_;
+    PipelineConfig pipeline_;
+    bool sparse_;
+    bool preallocate_;
+    ExtractOrder order_;
+    SyncMode sync_mode_;
+    uint64_t prefetch_budget_;
+    // Only set while a remote extraction runs
+    std::unique_ptr<RangePrefetcher> prefetcher_;
+
     bool readHeader();
     bool readManifest();
     bool readMetadataSignature();
-    bool extractPartition(const chromeos_update_engine::PartitionUpdate& partition,
-                          const std::string& output_path,
+    struct PartitionJob;
+    struct WorkerContext;
+    struct WriteBatch;
+
+    // Extract operations [begin, end) of one partition
+    bool extractOperations(PartitionJob& job,
+                           int begin,
+                           int end,
+                           ProgressTracker* progress_tracker,
+                           WorkerContext& context);
+#ifdef __linux__
+    bool extractOperationsIoUring(PartitionJob& job,
+                                  int begin,
+                                  int end,
+                                  ProgressTracker* progress_tracker,
+                                  WorkerContext& context);
+#endif
+    bool extractPipelined(const std::vector<std::unique_ptr<PartitionJob>>& jobs,
                           ProgressTracker* progress_tracker);
+    void reportProgress(PartitionJob& job, int count, ProgressTracker* progress_tracker);
+    // Marks the job failed; data prefetched for its operations is let go
+    void failJob(PartitionJob& job);
+    // Decodes one operation into *out_data/*out_size; *out_data is null when
+    // the destination range should just read as zeros
+    bool decodeOperation(const chromeos_update_engine::InstallOperation& operation,
+                         const std::string& name,
+                         const uint8_t* input,
+                         size_t input_size,
+                         const uint8_t* input_digest,
+                         DecoderCache& decoders,
+                         ScratchBuffer& decompressed_data,
+                         const uint8_t** out_data,
+                         size_t* out_size);
     int64_t readBytes(void* buffer, int64_t offset, int64_t length);
+    // readBytes() without the prefetcher
+    int64_t readSource(void* buffer, int64_t offset, int64_t length);
+    const uint8_t* mappedBytes(int64_t offset, int64_t length) const;
     static bool isUrl(const std::string& path);
+#ifdef HTTP_SUPPORT
+    void openCache();
+    bool openMirror();
+#endif
 };
 
 } // namespace payload_dumper
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace payload_dumper
+{
+
+// Fetches a known set of byte ranges of a slow (remote) input ahead of the
+// readers. Ranges closer than the gap threshold are merged into one request,
+// several requests run at once, and fetched data is held within a memory
+// budget until every range inside it has been read.
+class RangePrefetcher
+{
+  public:
+    struct Range {
+        int64_t offset;
+        int64_t length;
+    };
+
+    struct Config {
+        int64_t max_gap;     // largest hole between two ranges fetched together
+        int64_t max_request; // merged requests stop growing past this size
+        uint64_t budget;     // bytes of fetched data held at most
+        int threads;         // requests in flight
+    };
+
+    struct Stats {
+        uint64_t requests;
+        uint64_t fetched_bytes;
+        uint64_t gap_bytes;    // fetched only to merge requests
+        uint64_t hit_bytes;    // served from fetched data
+        uint64_t direct_bytes; // read by the caller's thread instead
+    };
+
+    // Same contract as Payload::readBytes(); called from the prefetch threads
+    using Fetch = std::function<int64_t(void* buffer, int64_t offset, int64_t length)>;
+
+    RangePrefetcher(Fetch fetch, std::vector<Range> ranges, const Config& config);
+    ~RangePrefetcher();
+
+    RangePrefetcher(const RangePrefetcher&) = delete;
+    RangePrefetcher& operator=(const RangePrefetcher&) = delete;
+
+    // Starts fetching in offset order
+    void start();
+
+    // Fills buffer with [offset, offset + length) if the prefetcher covers all
+    // of it, waiting for data in flight and reading parts that were not
+    // fetched yet directly. Returns the byte count, 0 when the range is not
+    // covered (the caller reads it itself), or -1 on error.
+    int64_t read(void* buffer, int64_t offset, int64_t length);
+
+    // Drops the given ranges from what readers are waiting for, because they
+    // will not be read after all. Requests left with nothing to read are not
+    // fetched, or their data is freed.
+    void discard(const std::vector<Range>& ranges);
+
+    size_t requestCount() const;
+    Stats stats() const;
+
+  private:
+    enum class State {
+        Pending,
+        Loading,
+        Ready,
+        Released,
+        Direct, // claimed by a reader before a prefetch thread got to it
+        Failed,
+    };
+
+    struct Request {
+        int64_t offset;
+        int64_t length;
+        uint64_t needed;           // bytes of the wanted ranges inside this request
+        std::vector<Range> unread; // parts of them not read yet, in offset order
+        int copying;               // readers copying out of data without the lock
+        State state;
+        std::unique_ptr<uint8_t[]> data;
+    };
+
+    Fetch fetch_;
+    Config config_;
+    std::vector<Request> requests_;
+    std::vector<std::thread> threads_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable ready_cv_;
+    std::condition_variable budget_cv_;
+    size_t next_request_;
+    uint64_t held_bytes_;
+    bool stopping_;
+    Stats stats_;
+
+    void worker();
+    bool copyFrom(size_t index, uint8_t* out, int64_t offset, int64_t length);
+    // Removes [offset, offset + length) from the request's unread parts
+    static void consume(Request& request, int64_t offset, int64_t length);
+    // Frees the request's data, or skips fetching it, once nothing is unread
+    void releaseIfDone(Request& request);
+};
+
+} // namespace payload_dumper
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "file_io.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace payload_dumper
+{
+
+// Local copy of a remote file that fills in as ranges of it are read. The
+// copy starts out sparse and is tracked in fixed-size blocks; a bitmap of the
+// finished ones lives in a sidecar file (path + ".parts"), so a later or
+// interrupted run reads those locally and fetches only the gaps. The bitmap
+// is written in batches, each after syncing the copy, so after a crash it
+// may miss recent blocks but never claims one that is not on disk. A background
+// thread can fetch the blocks nobody asked for to complete the copy.
+// read() may be called from any number of threads at once.
+class RemoteMirror
+{
+  public:
+    // Reads the origin; same contract as PositionalFile::readAt()
+    using Fetch = std::function<int64_t(void* buffer, uint64_t offset, size_t length)>;
+
+    explicit RemoteMirror(Fetch fetch);
+    ~RemoteMirror();
+
+    RemoteMirror(const RemoteMirror&) = delete;
+    RemoteMirror& operator=(const RemoteMirror&) = delete;
+
+    // Resumes the copy at path if its sidecar was written for the same
+    // validator and size, otherwise starts it over. Without a validator a
+    // changed remote file cannot be detected, so the copy always starts over.
+    bool open(const std::string& path, const std::string& validator, uint64_t file_size);
+    // Stops the background fetch and flushes the copy and its bitmap
+    bool close();
+
+    // Same contract as PositionalFile::readAt(). Missing blocks are fetched
+    // whole, adjacent ones in a single request, and written to the copy.
+    int64_t read(void* buffer, uint64_t offset, size_t length);
+
+    // Fetches the remaining blocks in file order on a thread of its own
+    void startFill();
+    // Waits for that thread; true once the copy is complete
+    bool finishFill();
+
+    uint64_t size() const;
+    bool resumed() const;
+    uint64_t completeBytes() const;
+    // Bytes of reads served from the copy, and fetched because they were not
+    uint64_t localBytes() const;
+    uint64_t fetchedBytes() const;
+
+  private:
+    Fetch fetch_;
+    OutputFile data_;
+    OutputFile parts_;
+    uint64_t file_size_;
+    uint64_t block_count_;
+    int64_t bitmap_offset_; // where the bitmap starts in the sidecar
+    bool resumed_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable loaded_cv_;
+    std::vector<uint8_t> bitmap_;
+    std::unordered_set<uint64_t> loading_;
+    uint64_t complete_bytes_;
+    uint64_t unpersisted_bytes_; // stored since the bitmap was last written
+    bool stopping_;
+    std::mutex persist_mutex_;
+
+    std::thread fill_thread_;
+    std::atomic<uint64_t> local_bytes_;
+    std::atomic<uint64_t> fetched_bytes_;
+    std::atomic<bool> store_failed_;
+
+    bool isDone(uint64_t index) const;
+    uint64_t blockSize(uint64_t index) const;
+    // Fetches blocks [first, last], already claimed in loading_, into data
+    // and the copy; the claim is released either way
+    bool fetchRun(uint64_t first, uint64_t last, std::unique_ptr<uint8_t[]>& data);
+    // Syncs the copy, then writes the bitmap to the sidecar
+    bool persist();
+    void fill();
+};
+
+} // namespace payload_dumper
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace payload_dumper
+{
+
+// Growable byte buffer meant to be kept per thread and reused for every
+// operation. Unlike std::vector it never zero-fills, and growing it discards
+// the old contents, so steady-state extraction does no heap allocation.
+class ScratchBuffer
+{
+  public:
+    ScratchBuffer();
+    ~ScratchBuffer();
+
+    ScratchBuffer(ScratchBuffer&& other) noexcept;
+    ScratchBuffer& operator=(ScratchBuffer&& other) noexcept;
+    ScratchBuffer(const ScratchBuffer&) = delete;
+    ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+    // Makes room for size bytes and returns data(); the contents are undefined.
+    // Throws std::bad_alloc if the memory can not be reserved.
+    uint8_t* resize(size_t size);
+    void clear();
+
+    uint8_t* data();
+    const uint8_t* data() const;
+    size_t size() const;
+    bool empty() const;
+
+    // Back large buffers with transparent huge pages where the OS allows it
+    static void setHugePages(bool enabled);
+
+    // Process-wide count of buffer (re)allocations, for --stats
+    static uint64_t allocationCount();
+    static uint64_t allocatedBytes();
+
+  private:
+    uint8_t* data_;
+    size_t size_;
+    size_t capacity_;
+    bool mapped_;
+
+    void release();
+};
+
+} // namespace payload_dumper
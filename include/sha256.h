@@ -16,12 +16,16 @@
  * 
  * Or single-call convenience function:
  *   sha256(data, len, hash);
+ *
+ * Blocks are processed with SHA-NI on x86 or the ARMv8 crypto extensions
+ * when the CPU has them, chosen at runtime, and portable C otherwise.
  */
 
 #ifndef SHA256_H
 #define SHA256_H
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stddef.h>
 
@@ -66,7 +70,7 @@ static const uint32_t SHA256_K[64] = {
  * Process a single 512-bit block
  * Internal function - not part of public API
  */
-static inline void sha256_transform(SHA256_CTX *ctx, const uint8_t data[SHA256_BLOCK_SIZE])
+static inline void sha256_transform(uint32_t state[8], const uint8_t data[SHA256_BLOCK_SIZE])
 {
     uint32_t a, b, c, d, e, f, g, h, t1, t2, m[64];
     int i;
@@ -84,14 +88,14 @@ static inline void sha256_transform(SHA256_CTX *ctx, const uint8_t data[SHA256_B
     }
 
     /* Initialize working variables with current hash value */
-    a = ctx->state[0];
-    b = ctx->state[1];
-    c = ctx->state[2];
-    d = ctx->state[3];
-    e = ctx->state[4];
-    f = ctx->state[5];
-    g = ctx->state[6];
-    h = ctx->state[7];
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
 
     /* Main compression loop - 64 rounds */
     for (i = 0; i < 64; i++) {
@@ -108,14 +112,424 @@ static inline void sha256_transform(SHA256_CTX *ctx, const uint8_t data[SHA256_B
     }
 
     /* Add compressed chunk to current hash value */
-    ctx->state[0] += a;
-    ctx->state[1] += b;
-    ctx->state[2] += c;
-    ctx->state[3] += d;
-    ctx->state[4] += e;
-    ctx->state[5] += f;
-    ctx->state[6] += g;
-    ctx->state[7] += h;
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+/* Internal: process consecutive blocks, one implementation per CPU feature */
+typedef void (*sha256_blocks_fn)(uint32_t state[8], const uint8_t *data, size_t blocks);
+
+static inline void sha256_blocks_scalar(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    while (blocks--) {
+        sha256_transform(state, data);
+        data += SHA256_BLOCK_SIZE;
+    }
+}
+
+/*
+ * x86 SHA extensions (SHA-NI). Compiled with a target attribute so the
+ * baseline build flags stay generic; only called when cpuid reports support.
+ */
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <immintrin.h>
+#define SHA256_HAVE_SHANI 1
+#define SHA256_HAVE_AVX2 1
+#define SHA256_TARGET_SHANI
+#define SHA256_TARGET_AVX2
+#elif defined(__GNUC__) || defined(__clang__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA256_HAVE_SHANI 1
+#define SHA256_HAVE_AVX2 1
+#define SHA256_TARGET_SHANI __attribute__((target("sha,sse4.1")))
+#define SHA256_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#ifdef SHA256_HAVE_SHANI
+/*
+ * One group of four rounds. The message words for the next groups are
+ * expanded alongside: msg2 finishes W[next], msg1 starts W[prev].
+ */
+#define SHA256_SHANI_ROUNDS(cur, prev, next, g, expand2, expand1)                      \
+    do {                                                                               \
+        msg = _mm_add_epi32(cur, _mm_loadu_si128((const __m128i *)&SHA256_K[(g) * 4])); \
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);                           \
+        if (expand2) {                                                                 \
+            next = _mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4));                 \
+            next = _mm_sha256msg2_epu32(next, cur);                                    \
+        }                                                                              \
+        msg = _mm_shuffle_epi32(msg, 0x0E);                                            \
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);                           \
+        if (expand1) {                                                                 \
+            prev = _mm_sha256msg1_epu32(prev, cur);                                    \
+        }                                                                              \
+    } while (0)
+
+SHA256_TARGET_SHANI
+static inline void sha256_blocks_shani(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    const __m128i byteswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, msg, tmp, msg0, msg1, msg2, msg3, abef_save, cdgh_save;
+
+    /* The instructions want the state as ABEF/CDGH rather than ABCD/EFGH */
+    tmp = _mm_loadu_si128((const __m128i *)&state[0]);
+    state1 = _mm_loadu_si128((const __m128i *)&state[4]);
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    while (blocks--) {
+        abef_save = state0;
+        cdgh_save = state1;
+
+        msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), byteswap);
+        msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), byteswap);
+        msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), byteswap);
+        msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), byteswap);
+
+        SHA256_SHANI_ROUNDS(msg0, msg3, msg1, 0, 0, 0);
+        SHA256_SHANI_ROUNDS(msg1, msg0, msg2, 1, 0, 1);
+        SHA256_SHANI_ROUNDS(msg2, msg1, msg3, 2, 0, 1);
+        SHA256_SHANI_ROUNDS(msg3, msg2, msg0, 3, 1, 1);
+        SHA256_SHANI_ROUNDS(msg0, msg3, msg1, 4, 1, 1);
+        SHA256_SHANI_ROUNDS(msg1, msg0, msg2, 5, 1, 1);
+        SHA256_SHANI_ROUNDS(msg2, msg1, msg3, 6, 1, 1);
+        SHA256_SHANI_ROUNDS(msg3, msg2, msg0, 7, 1, 1);
+        SHA256_SHANI_ROUNDS(msg0, msg3, msg1, 8, 1, 1);
+        SHA256_SHANI_ROUNDS(msg1, msg0, msg2, 9, 1, 1);
+        SHA256_SHANI_ROUNDS(msg2, msg1, msg3, 10, 1, 1);
+        SHA256_SHANI_ROUNDS(msg3, msg2, msg0, 11, 1, 1);
+        SHA256_SHANI_ROUNDS(msg0, msg3, msg1, 12, 1, 1);
+        SHA256_SHANI_ROUNDS(msg1, msg0, msg2, 13, 1, 0);
+        SHA256_SHANI_ROUNDS(msg2, msg1, msg3, 14, 1, 0);
+        SHA256_SHANI_ROUNDS(msg3, msg2, msg0, 15, 0, 0);
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+        data += SHA256_BLOCK_SIZE;
+    }
+
+    /* Back to ABCD/EFGH */
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i *)&state[0], state0);
+    _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+#undef SHA256_SHANI_ROUNDS
+
+static inline int sha256_cpu_has_shani(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) {
+        return 0;
+    }
+    __cpuid(regs, 1);
+    if (!(regs[2] & (1 << 19))) { /* SSE4.1 */
+        return 0;
+    }
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 29)) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1)) {
+        return 0;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return 0;
+    }
+    return (ebx & (1u << 29)) != 0;
+#endif
+}
+#endif /* SHA256_HAVE_SHANI */
+
+/*
+ * Eight independent messages hashed side by side with AVX2, one 32-bit lane
+ * each. Without SHA instructions this is several times the throughput of the
+ * scalar code, provided there are enough messages to keep the lanes busy.
+ * The state is stored word-major: state[w][lane].
+ */
+#ifdef SHA256_HAVE_AVX2
+#define SHA256_X8_LANES 8
+
+#define SHA256_X8_ROTR(x, n) \
+    _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+
+SHA256_TARGET_AVX2
+static inline void sha256_x8_block_avx2(uint32_t state[8][SHA256_X8_LANES],
+                                        const uint8_t *const data[SHA256_X8_LANES])
+{
+    const __m256i byteswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                             12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m256i w[16], v[8], s[8];
+    int half, i;
+
+    /* Transpose the 8 x 16 message words so w[i] holds word i of every lane */
+    for (half = 0; half < 2; half++) {
+        __m256i r[8], t[8], u[8];
+        for (i = 0; i < 8; i++) {
+            r[i] = _mm256_loadu_si256((const __m256i *)(data[i] + half * 32));
+        }
+        for (i = 0; i < 8; i += 2) {
+            t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+            t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+        }
+        for (i = 0; i < 8; i += 4) {
+            u[i + 0] = _mm256_unpacklo_epi64(t[i + 0], t[i + 2]);
+            u[i + 1] = _mm256_unpackhi_epi64(t[i + 0], t[i + 2]);
+            u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+            u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+        }
+        for (i = 0; i < 4; i++) {
+            w[half * 8 + i] =
+                _mm256_shuffle_epi8(_mm256_permute2x128_si256(u[i], u[i + 4], 0x20), byteswap);
+            w[half * 8 + i + 4] =
+                _mm256_shuffle_epi8(_mm256_permute2x128_si256(u[i], u[i + 4], 0x31), byteswap);
+        }
+    }
+
+    for (i = 0; i < 8; i++) {
+        s[i] = _mm256_loadu_si256((const __m256i *)state[i]);
+        v[i] = s[i];
+    }
+
+    for (i = 0; i < 64; i++) {
+        __m256i wi, t1, t2, ch, maj;
+        if (i < 16) {
+            wi = w[i];
+        } else {
+            /* Message schedule kept as a 16-entry ring */
+            __m256i w2 = w[(i - 2) & 15], w15 = w[(i - 15) & 15];
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(SHA256_X8_ROTR(w2, 17),
+                                                           SHA256_X8_ROTR(w2, 19)),
+                                          _mm256_srli_epi32(w2, 10));
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(SHA256_X8_ROTR(w15, 7),
+                                                           SHA256_X8_ROTR(w15, 18)),
+                                          _mm256_srli_epi32(w15, 3));
+            wi = _mm256_add_epi32(_mm256_add_epi32(s1, w[(i - 7) & 15]),
+                                  _mm256_add_epi32(s0, w[i & 15]));
+            w[i & 15] = wi;
+        }
+
+        ch = _mm256_xor_si256(_mm256_and_si256(v[4], v[5]), _mm256_andnot_si256(v[4], v[6]));
+        t1 = _mm256_add_epi32(v[7], _mm256_xor_si256(_mm256_xor_si256(SHA256_X8_ROTR(v[4], 6),
+                                                                      SHA256_X8_ROTR(v[4], 11)),
+                                                     SHA256_X8_ROTR(v[4], 25)));
+        t1 = _mm256_add_epi32(_mm256_add_epi32(t1, ch),
+                              _mm256_add_epi32(_mm256_set1_epi32((int)SHA256_K[i]), wi));
+        maj = _mm256_or_si256(_mm256_and_si256(v[0], v[1]),
+                              _mm256_and_si256(v[2], _mm256_or_si256(v[0], v[1])));
+        t2 = _mm256_add_epi32(_mm256_xor_si256(_mm256_xor_si256(SHA256_X8_ROTR(v[0], 2),
+                                                                SHA256_X8_ROTR(v[0], 13)),
+                                               SHA256_X8_ROTR(v[0], 22)),
+                              maj);
+        v[7] = v[6];
+        v[6] = v[5];
+        v[5] = v[4];
+        v[4] = _mm256_add_epi32(v[3], t1);
+        v[3] = v[2];
+        v[2] = v[1];
+        v[1] = v[0];
+        v[0] = _mm256_add_epi32(t1, t2);
+    }
+
+    for (i = 0; i < 8; i++) {
+        _mm256_storeu_si256((__m256i *)state[i], _mm256_add_epi32(s[i], v[i]));
+    }
+}
+
+#undef SHA256_X8_ROTR
+
+static inline int sha256_cpu_has_avx2(void)
+{
+    unsigned long long xcr0;
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) {
+        return 0;
+    }
+    __cpuid(regs, 1);
+    if (!(regs[2] & (1 << 27))) { /* OSXSAVE */
+        return 0;
+    }
+    xcr0 = _xgetbv(0);
+    __cpuidex(regs, 7, 0);
+    return (xcr0 & 6) == 6 && (regs[1] & (1 << 5)) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx, lo, hi;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE)) {
+        return 0;
+    }
+    /* The OS must save the YMM registers, not just the CPU support them */
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    xcr0 = ((unsigned long long)hi << 32) | lo;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return 0;
+    }
+    return (xcr0 & 6) == 6 && (ebx & bit_AVX2) != 0;
+#endif
+}
+#endif /* SHA256_HAVE_AVX2 */
+
+/*
+ * ARMv8 cryptography extensions. Apple silicon always has them; on Linux and
+ * Android they are reported through the auxiliary vector.
+ */
+#if defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#if defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO)
+#define SHA256_HAVE_ARMV8 1
+#define SHA256_TARGET_ARMV8
+#elif defined(__clang__) && __clang_major__ >= 16
+#define SHA256_HAVE_ARMV8 1
+#define SHA256_TARGET_ARMV8 __attribute__((target("sha2")))
+#elif !defined(__clang__) && __GNUC__ >= 10
+#define SHA256_HAVE_ARMV8 1
+#define SHA256_TARGET_ARMV8 __attribute__((target("+crypto")))
+#endif
+#endif
+
+#ifdef SHA256_HAVE_ARMV8
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#endif
+
+/* Four rounds; while g < 12 the slot is refilled with W for group g + 4 */
+#define SHA256_ARMV8_ROUNDS(cur, m1, m2, m3, g)                           \
+    do {                                                                \
+        tmp = vaddq_u32(cur, vld1q_u32(&SHA256_K[(g) * 4]));            \
+        if ((g) < 12) {                                                 \
+            cur = vsha256su1q_u32(vsha256su0q_u32(cur, m1), m2, m3);    \
+        }                                                               \
+        abcd = state0;                                                  \
+        state0 = vsha256hq_u32(state0, state1, tmp);                    \
+        state1 = vsha256h2q_u32(state1, abcd, tmp);                     \
+    } while (0)
+
+SHA256_TARGET_ARMV8
+static inline void sha256_blocks_armv8(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    uint32x4_t state0 = vld1q_u32(&state[0]);
+    uint32x4_t state1 = vld1q_u32(&state[4]);
+    uint32x4_t msg0, msg1, msg2, msg3, tmp, abcd, abcd_save, efgh_save;
+
+    while (blocks--) {
+        abcd_save = state0;
+        efgh_save = state1;
+
+        msg0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 0)));
+        msg1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16)));
+        msg2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 32)));
+        msg3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 48)));
+
+        SHA256_ARMV8_ROUNDS(msg0, msg1, msg2, msg3, 0);
+        SHA256_ARMV8_ROUNDS(msg1, msg2, msg3, msg0, 1);
+        SHA256_ARMV8_ROUNDS(msg2, msg3, msg0, msg1, 2);
+        SHA256_ARMV8_ROUNDS(msg3, msg0, msg1, msg2, 3);
+        SHA256_ARMV8_ROUNDS(msg0, msg1, msg2, msg3, 4);
+        SHA256_ARMV8_ROUNDS(msg1, msg2, msg3, msg0, 5);
+        SHA256_ARMV8_ROUNDS(msg2, msg3, msg0, msg1, 6);
+        SHA256_ARMV8_ROUNDS(msg3, msg0, msg1, msg2, 7);
+        SHA256_ARMV8_ROUNDS(msg0, msg1, msg2, msg3, 8);
+        SHA256_ARMV8_ROUNDS(msg1, msg2, msg3, msg0, 9);
+        SHA256_ARMV8_ROUNDS(msg2, msg3, msg0, msg1, 10);
+        SHA256_ARMV8_ROUNDS(msg3, msg0, msg1, msg2, 11);
+        SHA256_ARMV8_ROUNDS(msg0, msg1, msg2, msg3, 12);
+        SHA256_ARMV8_ROUNDS(msg1, msg2, msg3, msg0, 13);
+        SHA256_ARMV8_ROUNDS(msg2, msg3, msg0, msg1, 14);
+        SHA256_ARMV8_ROUNDS(msg3, msg0, msg1, msg2, 15);
+
+        state0 = vaddq_u32(state0, abcd_save);
+        state1 = vaddq_u32(state1, efgh_save);
+        data += SHA256_BLOCK_SIZE;
+    }
+
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+
+#undef SHA256_ARMV8_ROUNDS
+
+static inline int sha256_cpu_has_armv8(void)
+{
+#if defined(__APPLE__)
+    return 1;
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & (1UL << 6)) != 0; /* HWCAP_SHA2 */
+#else
+    return 0;
+#endif
+}
+#endif /* SHA256_HAVE_ARMV8 */
+
+/*
+ * Pick the fastest block function this CPU supports. Set the environment
+ * variable SHA256_FORCE_SCALAR to compare against the portable code.
+ */
+static inline sha256_blocks_fn sha256_select(const char **name)
+{
+    const char *force = getenv("SHA256_FORCE_SCALAR");
+    if (!force || !*force) {
+#ifdef SHA256_HAVE_SHANI
+        if (sha256_cpu_has_shani()) {
+            *name = "sha-ni";
+            return sha256_blocks_shani;
+        }
+#endif
+#ifdef SHA256_HAVE_ARMV8
+        if (sha256_cpu_has_armv8()) {
+            *name = "armv8-crypto";
+            return sha256_blocks_armv8;
+        }
+#endif
+    }
+    *name = "scalar";
+    return sha256_blocks_scalar;
+}
+
+/* Selected once per process; C++ makes the first-use initialization thread safe */
+static inline sha256_blocks_fn sha256_dispatch(const char **name)
+{
+#ifdef __cplusplus
+    static const char *selected_name = NULL;
+    static const sha256_blocks_fn selected = sha256_select(&selected_name);
+#else
+    static const char *selected_name = NULL;
+    static sha256_blocks_fn selected = NULL;
+    if (!selected) {
+        selected = sha256_select(&selected_name);
+    }
+#endif
+    if (name) {
+        *name = selected_name;
+    }
+    return selected;
+}
+
+/*
+ * Name of the block implementation in use: "sha-ni", "armv8-crypto" or "scalar"
+ */
+static inline const char *sha256_implementation(void)
+{
+    const char *name;
+    sha256_dispatch(&name);
+    return name;
 }
 
 /*
@@ -169,16 +583,17 @@ static inline void sha256_update(SHA256_CTX *ctx, const void *data, size_t len)
         
         /* If buffer is full, process it */
         if (ctx->buffer_len == SHA256_BLOCK_SIZE) {
-            sha256_transform(ctx, ctx->buffer);
+            sha256_dispatch(NULL)(ctx->state, ctx->buffer, 1);
             ctx->buffer_len = 0;
         }
     }
     
     /* Process complete blocks directly from input */
-    while (remaining >= SHA256_BLOCK_SIZE) {
-        sha256_transform(ctx, input);
-        input += SHA256_BLOCK_SIZE;
-        remaining -= SHA256_BLOCK_SIZE;
+    if (remaining >= SHA256_BLOCK_SIZE) {
+        size_t blocks = remaining / SHA256_BLOCK_SIZE;
+        sha256_dispatch(NULL)(ctx->state, input, blocks);
+        input += blocks * SHA256_BLOCK_SIZE;
+        remaining -= blocks * SHA256_BLOCK_SIZE;
     }
     
     /* Store any remaining bytes in buffer */
@@ -260,6 +675,119 @@ static inline void sha256(const void *data, size_t len, uint8_t hash[SHA256_DIGE
     sha256_final(&ctx, hash);
 }
 
+/*
+ * Number of messages sha256_many() hashes at once: 8 when AVX2 lanes beat the
+ * single-stream code (no SHA instructions), 1 otherwise
+ */
+static inline size_t sha256_lanes(void)
+{
+#ifdef SHA256_HAVE_AVX2
+#ifdef __cplusplus
+    static const size_t lanes =
+        (sha256_dispatch(NULL) == sha256_blocks_scalar && sha256_cpu_has_avx2()) ? 8 : 1;
+#else
+    static size_t lanes = 0;
+    if (!lanes) {
+        lanes = (sha256_dispatch(NULL) == sha256_blocks_scalar && sha256_cpu_has_avx2()) ? 8 : 1;
+    }
+#endif
+    return lanes;
+#else
+    return 1;
+#endif
+}
+
+#ifdef SHA256_HAVE_AVX2
+/* Internal: sha256_many() over the AVX2 lanes */
+static inline void sha256_many_x8(const uint8_t *const *data, const size_t *lens, size_t count,
+                                  uint8_t (*hashes)[SHA256_DIGEST_SIZE])
+{
+    static const uint8_t idle_block[SHA256_BLOCK_SIZE] = {0};
+    uint32_t state[8][SHA256_X8_LANES];
+    const uint8_t *blocks[SHA256_X8_LANES];
+    size_t lane_msg[SHA256_X8_LANES];
+    size_t lane_pos[SHA256_X8_LANES];
+    size_t next = 0;
+    size_t lane, w;
+    int active;
+
+    for (lane = 0; lane < SHA256_X8_LANES; lane++) {
+        lane_msg[lane] = count;
+        lane_pos[lane] = 0;
+    }
+
+    for (;;) {
+        active = 0;
+        for (lane = 0; lane < SHA256_X8_LANES; lane++) {
+            size_t msg = lane_msg[lane];
+
+            /* Finish messages with less than a block left and refill the lane */
+            while (msg == count || lens[msg] - lane_pos[lane] < SHA256_BLOCK_SIZE) {
+                if (msg != count) {
+                    SHA256_CTX ctx;
+                    for (w = 0; w < 8; w++) {
+                        ctx.state[w] = state[w][lane];
+                    }
+                    ctx.count = lane_pos[lane];
+                    ctx.buffer_len = 0;
+                    sha256_update(&ctx, data[msg] + lane_pos[lane], lens[msg] - lane_pos[lane]);
+                    sha256_final(&ctx, hashes[msg]);
+                }
+                if (next == count) {
+                    msg = count;
+                    break;
+                }
+                msg = next++;
+                lane_pos[lane] = 0;
+                state[0][lane] = 0x6a09e667;
+                state[1][lane] = 0xbb67ae85;
+                state[2][lane] = 0x3c6ef372;
+                state[3][lane] = 0xa54ff53a;
+                state[4][lane] = 0x510e527f;
+                state[5][lane] = 0x9b05688c;
+                state[6][lane] = 0x1f83d9ab;
+                state[7][lane] = 0x5be0cd19;
+            }
+            lane_msg[lane] = msg;
+
+            if (msg == count) {
+                blocks[lane] = idle_block;
+            } else {
+                blocks[lane] = data[msg] + lane_pos[lane];
+                lane_pos[lane] += SHA256_BLOCK_SIZE;
+                active = 1;
+            }
+        }
+
+        if (!active) {
+            break;
+        }
+        sha256_x8_block_avx2(state, blocks);
+    }
+}
+#endif
+
+/*
+ * Hash count independent messages: hashes[i] = SHA-256(data[i], lens[i]).
+ * With multiple lanes, a lane that runs out of whole blocks finishes its
+ * message with the scalar code and picks up the next one.
+ */
+static inline void sha256_many(const uint8_t *const *data, const size_t *lens, size_t count,
+                               uint8_t (*hashes)[SHA256_DIGEST_SIZE])
+{
+    size_t i;
+
+#ifdef SHA256_HAVE_AVX2
+    if (count > 1 && sha256_lanes() == SHA256_X8_LANES) {
+        sha256_many_x8(data, lens, count, hashes);
+        return;
+    }
+#endif
+    for (i = 0; i < count; i++) {
+        sha256(data[i], lens[i], hashes[i]);
+    }
+}
+
 /*
  * Convert binary hash to hexadecimal string
  * 
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace payload_dumper
+{
+
+// Fixed-size pool where every thread owns a deque of tasks. A thread works
+// through its own deque from the front and, once it runs dry, steals from the
+// back of the others, so uneven tasks no longer leave threads idle at the end.
+class WorkStealingPool
+{
+  public:
+    // Receives the index of the thread running it, for per-thread state
+    using Task = std::function<void(int)>;
+
+    struct Stats {
+        uint64_t tasks;
+        uint64_t steals;
+        // Sum over threads of the time between a thread running out of work
+        // and the last thread finishing
+        double tail_idle_ms;
+        double wall_ms;
+    };
+
+    explicit WorkStealingPool(int threads);
+
+    int size() const;
+
+    // Deals tasks round-robin in the given order (so callers sort them
+    // largest-first), runs them all and returns when every task has finished.
+    void run(std::vector<Task> tasks);
+
+    const Stats& stats() const;
+
+  private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    Stats stats_;
+
+    bool popLocal(int index, Task& task);
+    bool steal(int index, Task& task);
+};
+
+} // namespace payload_dumper
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ZERO_SCAN_SSE2 1
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define ZERO_SCAN_NEON 1
+#endif
+
+namespace payload_dumper
+{
+
+// True when every byte of data is zero. Sized for block-at-a-time checks:
+// 64 bytes are OR-ed together per step and tested once, with SSE2 on x86 and
+// NEON on ARM (both part of the baseline ISA), 64-bit words elsewhere.
+inline bool isAllZero(const uint8_t* data, size_t size)
+{
+    size_t pos = 0;
+
+#if defined(ZERO_SCAN_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; pos + 64 <= size; pos += 64) {
+        const __m128i* p = reinterpret_cast<const __m128i*>(data + pos);
+        __m128i acc = _mm_or_si128(_mm_or_si128(_mm_loadu_si128(p), _mm_loadu_si128(p + 1)),
+                                   _mm_or_si128(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, zero)) != 0xFFFF) {
+            return false;
+        }
+    }
+#elif defined(ZERO_SCAN_NEON)
+    for (; pos + 64 <= size; pos += 64) {
+        uint8x16_t acc = vorrq_u8(vorrq_u8(vld1q_u8(data + pos), vld1q_u8(data + pos + 16)),
+                                  vorrq_u8(vld1q_u8(data + pos + 32), vld1q_u8(data + pos + 48)));
+        uint64x2_t wide = vreinterpretq_u64_u8(acc);
+        if ((vgetq_lane_u64(wide, 0) | vgetq_lane_u64(wide, 1)) != 0) {
+            return false;
+        }
+    }
+#else
+    for (; pos + 64 <= size; pos += 64) {
+        uint64_t words[8];
+        memcpy(words, data + pos, sizeof(words));
+        if ((words[0] | words[1] | words[2] | words[3] | words[4] | words[5] | words[6] |
+             words[7]) != 0) {
+            return false;
+        }
+    }
+#endif
+
+    for (; pos < size; ++pos) {
+        if (data[pos] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace payload_dumper
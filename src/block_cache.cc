@@ -0,0 +1,270 @@
+#include "block_cache.hpp"
+#include "file_io.hpp"
+#include "sha256.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace payload_dumper
+{
+
+// Unit of caching and eviction; misses are rounded out to whole blocks
+static constexpr uint64_t CACHE_BLOCK_BYTES = 1024 * 1024;
+// Block files are named by a hex SHA-256
+static constexpr size_t CACHE_NAME_LENGTH = 64;
+// A block being written, renamed into place once complete
+static constexpr const char* CACHE_PART_SUFFIX = ".part";
+
+BlockCache::BlockCache(Fetch fetch)
+    : fetch_(std::move(fetch)), file_size_(0), max_bytes_(0), total_bytes_(0), hit_bytes_(0),
+      miss_bytes_(0), store_failed_(false)
+{
+}
+
+bool BlockCache::open(const std::string& dir,
+                      const std::string& key,
+                      uint64_t file_size,
+                      uint64_t max_bytes)
+{
+    dir_ = dir;
+    key_ = key;
+    file_size_ = file_size;
+    max_bytes_ = max_bytes;
+
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    if (ec) {
+        std::cerr << "Failed to create cache directory " << dir_ << ": " << ec.message() << "\n";
+        return false;
+    }
+
+    struct Found {
+        fs::file_time_type used;
+        std::string name;
+        uint64_t size;
+    };
+    std::vector<Found> found;
+    for (fs::directory_iterator it(dir_, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code item_ec;
+        std::string name = it->path().filename().string();
+        // Left behind by a run that stopped while storing a block
+        if (name.size() == CACHE_NAME_LENGTH + strlen(CACHE_PART_SUFFIX) &&
+            name.compare(CACHE_NAME_LENGTH, std::string::npos, CACHE_PART_SUFFIX) == 0) {
+            fs::remove(it->path(), item_ec);
+            continue;
+        }
+        if (name.size() != CACHE_NAME_LENGTH || !it->is_regular_file(item_ec)) {
+            continue;
+        }
+        uint64_t size = it->file_size(item_ec);
+        fs::file_time_type used = it->last_write_time(item_ec);
+        if (!item_ec) {
+            found.push_back({used, name, size});
+        }
+    }
+    if (ec) {
+        std::cerr << "Failed to read cache directory " << dir_ << ": " << ec.message() << "\n";
+        return false;
+    }
+
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) {
+        return a.used > b.used;
+    });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& block : found) {
+        lru_.push_back(block.name);
+        entries_[block.name] = {block.size, std::prev(lru_.end())};
+        total_bytes_ += block.size;
+    }
+    evict();
+    return true;
+}
+
+uint64_t BlockCache::size() const
+{
+    return file_size_;
+}
+
+uint64_t BlockCache::hitBytes() const
+{
+    return hit_bytes_;
+}
+
+uint64_t BlockCache::missBytes() const
+{
+    return miss_bytes_;
+}
+
+std::string BlockCache::blockName(uint64_t index) const
+{
+    std::string id = key_ + "\n" + std::to_string(index);
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha256(id.data(), id.size(), digest);
+    char hex[65];
+    sha256_to_hex(digest, hex);
+    return std::string(hex, CACHE_NAME_LENGTH);
+}
+
+uint64_t BlockCache::blockSize(uint64_t index) const
+{
+    return std::min(CACHE_BLOCK_BYTES, file_size_ - index * CACHE_BLOCK_BYTES);
+}
+
+bool BlockCache::loadBlock(const std::string& name,
+                           uint64_t block_size,
+                           uint8_t* out,
+                           uint64_t offset,
+                           uint64_t length)
+{
+    const fs::path path = fs::path(dir_) / name;
+    PositionalFile file;
+    if (!file.open(path.string()) || static_cast<uint64_t>(file.size()) != block_size ||
+        file.readAt(out, static_cast<int64_t>(offset), static_cast<int64_t>(length)) !=
+            static_cast<int64_t>(length)) {
+        return false;
+    }
+    file.close();
+
+    // Keeps the block's place in the eviction order for later runs
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+void BlockCache::storeBlock(uint64_t index, const uint8_t* data)
+{
+    const std::string name = blockName(index);
+    const uint64_t size = blockSize(index);
+    const fs::path path = fs::path(dir_) / name;
+    const fs::path part = fs::path(dir_) / (name + CACHE_PART_SUFFIX);
+
+    OutputFile file;
+    bool ok = file.open(part.string()) && file.writeAt(data, static_cast<size_t>(size), 0);
+    ok = file.close() && ok;
+    std::error_code ec;
+    if (ok) {
+        fs::rename(part, path, ec);
+    }
+    if (!ok || ec) {
+        fs::remove(part, ec);
+        if (!store_failed_.exchange(true)) {
+            std::cerr << "Warning: failed to store data in cache directory " << dir_ << "\n";
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.count(name) == 0) {
+        lru_.push_front(name);
+        entries_[name] = {size, lru_.begin()};
+        total_bytes_ += size;
+    }
+    evict();
+}
+
+void BlockCache::evict()
+{
+    while (total_bytes_ > max_bytes_ && !lru_.empty()) {
+        const std::string& name = lru_.back();
+        std::error_code ec;
+        fs::remove(fs::path(dir_) / name, ec);
+        total_bytes_ -= entries_[name].size;
+        entries_.erase(name);
+        lru_.pop_back();
+    }
+}
+
+int64_t BlockCache::read(void* buffer, uint64_t offset, size_t length)
+{
+    if (offset >= file_size_ || length == 0) {
+        return 0;
+    }
+
+    const uint64_t end = std::min<uint64_t>(offset + length, file_size_);
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    uint64_t pos = offset;
+    while (pos < end) {
+        const uint64_t index = pos / CACHE_BLOCK_BYTES;
+        const std::string name = blockName(index);
+
+        // Another reader fetching this block stores it for us
+        std::unique_lock<std::mutex> lock(mutex_);
+        loaded_cv_.wait(lock, [&] { return loading_.count(index) == 0; });
+
+        auto it = entries_.find(name);
+        if (it != entries_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+            lock.unlock();
+
+            const uint64_t block_end = std::min(end, (index + 1) * CACHE_BLOCK_BYTES);
+            if (loadBlock(name,
+                          blockSize(index),
+                          out + (pos - offset),
+                          pos - index * CACHE_BLOCK_BYTES,
+                          block_end - pos)) {
+                hit_bytes_ += block_end - pos;
+                pos = block_end;
+                continue;
+            }
+
+            // Evicted meanwhile, or damaged: forget it and fetch it again
+            lock.lock();
+            it = entries_.find(name);
+            if (it != entries_.end()) {
+                total_bytes_ -= it->second.size;
+                lru_.erase(it->second.lru);
+                entries_.erase(it);
+            }
+            continue;
+        }
+
+        // Take over the run of following blocks that are missing as well, so
+        // they arrive in one request
+        uint64_t last = index;
+        loading_.insert(index);
+        while ((last + 1) * CACHE_BLOCK_BYTES < end && loading_.count(last + 1) == 0 &&
+               entries_.count(blockName(last + 1)) == 0) {
+            loading_.insert(++last);
+        }
+        lock.unlock();
+
+        const uint64_t run_offset = index * CACHE_BLOCK_BYTES;
+        const uint64_t run_length = std::min(file_size_, (last + 1) * CACHE_BLOCK_BYTES) - run_offset;
+        std::unique_ptr<uint8_t[]> data(new (std::nothrow) uint8_t[run_length]);
+        const bool ok = data && fetch_(data.get(), run_offset, static_cast<size_t>(run_length)) ==
+                                    static_cast<int64_t>(run_length);
+        if (ok) {
+            for (uint64_t i = index; i <= last; ++i) {
+                storeBlock(i, data.get() + (i - index) * CACHE_BLOCK_BYTES);
+            }
+        }
+
+        lock.lock();
+        for (uint64_t i = index; i <= last; ++i) {
+            loading_.erase(i);
+        }
+        lock.unlock();
+        loaded_cv_.notify_all();
+
+        if (!ok) {
+            return -1;
+        }
+
+        const uint64_t run_end = std::min(end, run_offset + run_length);
+        memcpy(out + (pos - offset), data.get() + (pos - run_offset), run_end - pos);
+        miss_bytes_ += run_end - pos;
+        pos = run_end;
+    }
+    return static_cast<int64_t>(end - offset);
+}
+
+} // namespace payload_dumper
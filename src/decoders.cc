@@ -0,0 +1,190 @@
+#include "decoders.hpp"
+
+#include <atomic>
+#include <bzlib.h>
+#include <cstdlib>
+#include <cstring>
+#include <lzma.h>
+#include <vector>
+#include <zstd.h>
+
+namespace payload_dumper
+{
+
+// Free blocks kept for reuse; bzip2 needs at most three live allocations
+static constexpr size_t BZ_POOL_SIZE = 8;
+
+static std::atomic<uint64_t> setup_count{0};
+
+// Recycles bzip2's allocations: its decompressor state and the block-sized
+// tt array are the same sizes for every stream of a payload, so after the
+// first operation init is served from here instead of malloc/mmap.
+struct BzAllocPool {
+    struct Block {
+        void* ptr;
+        size_t size;
+        bool in_use;
+    };
+    std::vector<Block> blocks;
+
+    void* allocate(size_t size)
+    {
+        for (auto& block : blocks) {
+            if (!block.in_use && block.size == size) {
+                block.in_use = true;
+                return block.ptr;
+            }
+        }
+
+        if (blocks.size() >= BZ_POOL_SIZE) {
+            for (auto it = blocks.begin(); it != blocks.end(); ++it) {
+                if (!it->in_use) {
+                    std::free(it->ptr);
+                    blocks.erase(it);
+                    break;
+                }
+            }
+        }
+
+        void* ptr = std::malloc(size);
+        if (ptr) {
+            blocks.push_back({ptr, size, true});
+            setup_count++;
+        }
+        return ptr;
+    }
+
+    void release(void* ptr)
+    {
+        for (auto& block : blocks) {
+            if (block.ptr == ptr) {
+                block.in_use = false;
+                return;
+            }
+        }
+        std::free(ptr);
+    }
+
+    ~BzAllocPool()
+    {
+        for (auto& block : blocks) {
+            std::free(block.ptr);
+        }
+    }
+};
+
+struct DecoderCache::State {
+    ZSTD_DCtx* zstd = nullptr;
+    lzma_stream xz = LZMA_STREAM_INIT;
+    bool xz_initialized = false;
+    BzAllocPool bz_blocks;
+};
+
+static void* bzAlloc(void* opaque, int items, int size)
+{
+    return static_cast<BzAllocPool*>(opaque)->allocate(static_cast<size_t>(items) * size);
+}
+
+static void bzFree(void* opaque, void* ptr)
+{
+    static_cast<BzAllocPool*>(opaque)->release(ptr);
+}
+
+DecoderCache::DecoderCache() : state_(new State)
+{
+}
+
+DecoderCache::~DecoderCache()
+{
+    if (state_->zstd) {
+        ZSTD_freeDCtx(state_->zstd);
+    }
+    if (state_->xz_initialized) {
+        lzma_end(&state_->xz);
+    }
+}
+
+uint64_t DecoderCache::setupCount()
+{
+    return setup_count;
+}
+
+bool DecoderCache::decodeXz(const uint8_t* in,
+                            size_t in_size,
+                            uint8_t* out,
+                            size_t out_capacity,
+                            size_t* out_size)
+{
+    // Initializing a stream that is already set up reuses its allocations
+    lzma_stream& strm = state_->xz;
+    if (lzma_stream_decoder(&strm, UINT64_MAX, 0) != LZMA_OK) {
+        return false;
+    }
+    if (!state_->xz_initialized) {
+        state_->xz_initialized = true;
+        setup_count++;
+    }
+
+    strm.next_in = in;
+    strm.avail_in = in_size;
+    strm.next_out = out;
+    strm.avail_out = out_capacity;
+
+    lzma_ret ret = lzma_code(&strm, LZMA_FINISH);
+    *out_size = out_capacity - strm.avail_out;
+    return ret == LZMA_STREAM_END;
+}
+
+bool DecoderCache::decodeBz2(const uint8_t* in,
+                             size_t in_size,
+                             uint8_t* out,
+                             size_t out_capacity,
+                             size_t* out_size)
+{
+    if (in_size > UINT32_MAX || out_capacity > UINT32_MAX) {
+        return false;
+    }
+
+    bz_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    strm.bzalloc = bzAlloc;
+    strm.bzfree = bzFree;
+    strm.opaque = &state_->bz_blocks;
+    if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK) {
+        return false;
+    }
+
+    strm.next_in = const_cast<char*>(reinterpret_cast<const char*>(in));
+    strm.avail_in = static_cast<unsigned int>(in_size);
+    strm.next_out = reinterpret_cast<char*>(out);
+    strm.avail_out = static_cast<unsigned int>(out_capacity);
+
+    int ret = BZ2_bzDecompress(&strm);
+    *out_size = out_capacity - strm.avail_out;
+    BZ2_bzDecompressEnd(&strm);
+    return ret == BZ_STREAM_END;
+}
+
+bool DecoderCache::decodeZstd(const uint8_t* in,
+                              size_t in_size,
+                              uint8_t* out,
+                              size_t out_capacity,
+                              size_t* out_size)
+{
+    if (!state_->zstd) {
+        state_->zstd = ZSTD_createDCtx();
+        if (!state_->zstd) {
+            return false;
+        }
+        setup_count++;
+    }
+
+    size_t ret = ZSTD_decompressDCtx(state_->zstd, out, out_capacity, in, in_size);
+    if (ZSTD_isError(ret)) {
+        return false;
+    }
+    *out_size = ret;
+    return true;
+}
+
+} // namespace payload_dumper
@@ -0,0 +1,882 @@
+#define NOMINMAX
+#include "file_io.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <cstdio>
+#include <fcntl.h>
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/falloc.h>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+namespace payload_dumper
+{
+
+#ifdef __linux__
+// Buffers handed to one pwritev call; well under IOV_MAX everywhere
+static constexpr int MAX_WRITE_SEGMENTS = 64;
+// Reflinks are only attempted for ranges aligned to this; it covers the
+// block size of the filesystems that support them
+static constexpr int64_t CLONE_ALIGNMENT = 4096;
+#endif
+
+// Largest buffer used to read and drop the bytes a stream skips over
+static constexpr int64_t STREAM_SKIP_CHUNK = 1024 * 1024;
+
+PositionalFile::PositionalFile()
+    :
+#ifdef _WIN32
+      handle_(INVALID_HANDLE_VALUE), mapping_(nullptr),
+#else
+      fd_(-1),
+#endif
+      size_(0), map_(nullptr)
+{
+}
+
+PositionalFile::~PositionalFile()
+{
+    close();
+}
+
+bool PositionalFile::open(const std::string& path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE h = CreateFileA(path.c_str(),
+                           GENERIC_READ,
+                           FILE_SHARE_READ,
+                           nullptr,
+                           OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(h, &file_size)) {
+        CloseHandle(h);
+        return false;
+    }
+
+    handle_ = h;
+    size_ = file_size.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_BINARY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    size_ = st.st_size;
+#endif
+    return true;
+}
+
+void PositionalFile::close()
+{
+#ifdef _WIN32
+    if (map_) {
+        UnmapViewOfFile(map_);
+        map_ = nullptr;
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+    if (handle_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle_);
+        handle_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (map_) {
+        munmap(map_, static_cast<size_t>(size_));
+        map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+#endif
+    size_ = 0;
+}
+
+bool PositionalFile::isOpen() const
+{
+#ifdef _WIN32
+    return handle_ != INVALID_HANDLE_VALUE;
+#else
+    return fd_ >= 0;
+#endif
+}
+
+int64_t PositionalFile::size() const
+{
+    return size_;
+}
+
+int PositionalFile::fd() const
+{
+#ifdef _WIN32
+    return -1;
+#else
+    return fd_;
+#endif
+}
+
+int64_t PositionalFile::readAt(void* buffer, int64_t offset, int64_t length) const
+{
+    if (!isOpen() || offset < 0 || length < 0) {
+        return -1;
+    }
+
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    int64_t total = 0;
+
+    while (total < length) {
+#ifdef _WIN32
+        // ReadFile takes a DWORD length, and the OVERLAPPED offset makes it
+        // positional without touching the handle's file pointer.
+        DWORD chunk = static_cast<DWORD>(std::min<int64_t>(length - total, 1 << 30));
+        OVERLAPPED ov = {};
+        uint64_t pos = static_cast<uint64_t>(offset + total);
+        ov.Offset = static_cast<DWORD>(pos & 0xFFFFFFFFu);
+        ov.OffsetHigh = static_cast<DWORD>(pos >> 32);
+
+        DWORD got = 0;
+        if (!ReadFile(handle_, out + total, chunk, &got, &ov)) {
+            if (GetLastError() == ERROR_HANDLE_EOF) {
+                break;
+            }
+            return -1;
+        }
+#else
+        ssize_t got = pread(fd_, out + total, static_cast<size_t>(length - total), offset + total);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+#endif
+        if (got == 0) {
+            break;
+        }
+        total += got;
+    }
+
+    return total;
+}
+
+bool PositionalFile::map()
+{
+    if (map_) {
+        return true;
+    }
+    if (!isOpen() || size_ <= 0 ||
+        static_cast<uint64_t>(size_) > static_cast<uint64_t>(SIZE_MAX)) {
+        return false;
+    }
+
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingA(handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+    mapping_ = mapping;
+    map_ = static_cast<uint8_t*>(view);
+#else
+    void* addr = mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    map_ = static_cast<uint8_t*>(addr);
+#endif
+    return true;
+}
+
+const uint8_t* PositionalFile::data() const
+{
+    return map_;
+}
+
+void PositionalFile::adviseSequential() const
+{
+#if !defined(_WIN32) && defined(MADV_SEQUENTIAL)
+    if (map_) {
+        madvise(map_, static_cast<size_t>(size_), MADV_SEQUENTIAL);
+    }
+#endif
+}
+
+void PositionalFile::adviseWillNeed(int64_t offset, int64_t length) const
+{
+#if !defined(_WIN32) && defined(MADV_WILLNEED)
+    if (!map_ || length <= 0 || offset < 0 || offset >= size_) {
+        return;
+    }
+
+    // madvise wants a page-aligned start address
+    static const int64_t page = sysconf(_SC_PAGESIZE) > 0 ? sysconf(_SC_PAGESIZE) : 4096;
+    int64_t end = std::min(offset + length, size_);
+    int64_t start = offset - (offset % page);
+    madvise(map_ + start, static_cast<size_t>(end - start), MADV_WILLNEED);
+#else
+    (void)offset;
+    (void)length;
+#endif
+}
+
+StreamFile::StreamFile()
+    :
+#ifdef _WIN32
+      handle_(INVALID_HANDLE_VALUE),
+#else
+      fd_(-1),
+#endif
+      owned_(false), position_(0)
+{
+}
+
+StreamFile::~StreamFile()
+{
+    close();
+}
+
+bool StreamFile::open(const std::string& path)
+{
+    close();
+
+#ifdef _WIN32
+    if (path == "-") {
+        _setmode(_fileno(stdin), _O_BINARY);
+        handle_ = GetStdHandle(STD_INPUT_HANDLE);
+        owned_ = false;
+    } else {
+        handle_ = CreateFileA(path.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+        owned_ = true;
+    }
+    if (handle_ == INVALID_HANDLE_VALUE || handle_ == nullptr) {
+        handle_ = INVALID_HANDLE_VALUE;
+        return false;
+    }
+#else
+    if (path == "-") {
+        fd_ = STDIN_FILENO;
+        owned_ = false;
+    } else {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_BINARY);
+        if (fd_ < 0) {
+            return false;
+        }
+        owned_ = true;
+    }
+#endif
+    position_ = 0;
+    return true;
+}
+
+void StreamFile::close()
+{
+#ifdef _WIN32
+    if (owned_ && handle_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle_);
+    }
+    handle_ = INVALID_HANDLE_VALUE;
+#else
+    if (owned_ && fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+#endif
+    owned_ = false;
+    position_ = 0;
+}
+
+bool StreamFile::isOpen() const
+{
+#ifdef _WIN32
+    return handle_ != INVALID_HANDLE_VALUE;
+#else
+    return fd_ >= 0;
+#endif
+}
+
+int64_t StreamFile::position() const
+{
+    return position_;
+}
+
+int64_t StreamFile::read(void* buffer, int64_t length)
+{
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    int64_t total = 0;
+
+    while (total < length) {
+#ifdef _WIN32
+        DWORD chunk = static_cast<DWORD>(std::min<int64_t>(length - total, 1 << 30));
+        DWORD got = 0;
+        if (!ReadFile(handle_, out + total, chunk, &got, nullptr)) {
+            // A pipe whose writer has gone away reports this instead of EOF
+            if (GetLastError() == ERROR_BROKEN_PIPE || GetLastError() == ERROR_HANDLE_EOF) {
+                break;
+            }
+            return -1;
+        }
+#else
+        ssize_t got = ::read(fd_, out + total, static_cast<size_t>(length - total));
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+#endif
+        if (got == 0) {
+            break;
+        }
+        total += got;
+    }
+
+    position_ += total;
+    return total;
+}
+
+int64_t StreamFile::readAt(void* buffer, int64_t offset, int64_t length)
+{
+    if (length == 0) {
+        return 0;
+    }
+    if (!isOpen() || offset < position_ || length < 0) {
+        return -1;
+    }
+
+    if (offset > position_) {
+        std::vector<uint8_t> discard(
+            static_cast<size_t>(std::min(offset - position_, STREAM_SKIP_CHUNK)));
+        while (position_ < offset) {
+            int64_t chunk = std::min<int64_t>(offset - position_, discard.size());
+            int64_t got = read(discard.data(), chunk);
+            if (got < 0) {
+                return -1;
+            }
+            if (got < chunk) {
+                return 0;
+            }
+        }
+    }
+
+    return read(buffer, length);
+}
+
+bool StreamFile::isStream(const std::string& path)
+{
+    if (path == "-") {
+        return true;
+    }
+#ifdef _WIN32
+    return false;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    return S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode) || S_ISCHR(st.st_mode);
+#endif
+}
+
+OutputFile::OutputFile()
+    :
+#ifdef _WIN32
+      handle_(INVALID_HANDLE_VALUE),
+#else
+      fd_(-1),
+#endif
+      sync_interval_(0), unsynced_(0), syscalls_(0), syncs_(0)
+{
+}
+
+OutputFile::~OutputFile()
+{
+    close();
+}
+
+bool OutputFile::open(const std::string& path, bool truncate)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE h = CreateFileA(path.c_str(),
+                           GENERIC_READ | GENERIC_WRITE,
+                           FILE_SHARE_READ,
+                           nullptr,
+                           truncate ? CREATE_ALWAYS : OPEN_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    handle_ = h;
+#else
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0) | O_BINARY, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    fd_ = fd;
+#endif
+    return true;
+}
+
+bool OutputFile::close()
+{
+    bool ok = true;
+#ifdef _WIN32
+    if (handle_ != INVALID_HANDLE_VALUE) {
+        ok = CloseHandle(handle_) != 0;
+        handle_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (fd_ >= 0) {
+        ok = ::close(fd_) == 0;
+        fd_ = -1;
+    }
+#endif
+    return ok;
+}
+
+bool OutputFile::isOpen() const
+{
+#ifdef _WIN32
+    return handle_ != INVALID_HANDLE_VALUE;
+#else
+    return fd_ >= 0;
+#endif
+}
+
+int OutputFile::fd() const
+{
+#ifdef _WIN32
+    return -1;
+#else
+    return fd_;
+#endif
+}
+
+bool OutputFile::writeAt(const void* data, size_t size, int64_t offset) const
+{
+    if (!isOpen() || offset < 0) {
+        return false;
+    }
+
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    const size_t total = size;
+    while (size > 0) {
+        syscalls_++;
+#ifdef _WIN32
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1 << 30));
+        OVERLAPPED ov = {};
+        uint64_t pos = static_cast<uint64_t>(offset);
+        ov.Offset = static_cast<DWORD>(pos & 0xFFFFFFFFu);
+        ov.OffsetHigh = static_cast<DWORD>(pos >> 32);
+
+        DWORD written = 0;
+        if (!WriteFile(handle_, in, chunk, &written, &ov)) {
+            return false;
+        }
+#else
+        ssize_t written = pwrite(fd_, in, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+#endif
+        if (written == 0) {
+            return false;
+        }
+        in += written;
+        size -= static_cast<size_t>(written);
+        offset += written;
+    }
+    return addWritten(total);
+}
+
+bool OutputFile::writeAt(const WriteSegment* segments, size_t count, int64_t offset) const
+{
+    if (!isOpen() || offset < 0) {
+        return false;
+    }
+
+#ifdef __linux__
+    // Bytes of segments[index] that already went out after a short write
+    const int64_t start = offset;
+    size_t index = 0;
+    size_t done = 0;
+    while (true) {
+        while (index < count && done == segments[index].size) {
+            index++;
+            done = 0;
+        }
+        if (index == count) {
+            return addWritten(static_cast<uint64_t>(offset - start));
+        }
+
+        struct iovec iov[MAX_WRITE_SEGMENTS];
+        int iov_count = 0;
+        for (size_t i = index; i < count && iov_count < MAX_WRITE_SEGMENTS; ++i) {
+            size_t skip = i == index ? done : 0;
+            iov[iov_count].iov_base =
+                const_cast<uint8_t*>(static_cast<const uint8_t*>(segments[i].data)) + skip;
+            iov[iov_count].iov_len = segments[i].size - skip;
+            iov_count++;
+        }
+
+        syscalls_++;
+        ssize_t written = pwritev(fd_, iov, iov_count, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (written == 0) {
+            return false;
+        }
+        offset += written;
+
+        size_t left = static_cast<size_t>(written);
+        while (left > 0) {
+            size_t rest = segments[index].size - done;
+            if (left < rest) {
+                done += left;
+                break;
+            }
+            left -= rest;
+            index++;
+            done = 0;
+        }
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+        if (!writeAt(segments[i].data, segments[i].size, offset)) {
+            return false;
+        }
+        offset += segments[i].size;
+    }
+    return true;
+#endif
+}
+
+int64_t OutputFile::readAt(void* buffer, int64_t offset, int64_t length) const
+{
+    if (!isOpen() || offset < 0 || length < 0) {
+        return -1;
+    }
+
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    int64_t total = 0;
+
+    while (total < length) {
+#ifdef _WIN32
+        DWORD chunk = static_cast<DWORD>(std::min<int64_t>(length - total, 1 << 30));
+        OVERLAPPED ov = {};
+        uint64_t pos = static_cast<uint64_t>(offset + total);
+        ov.Offset = static_cast<DWORD>(pos & 0xFFFFFFFFu);
+        ov.OffsetHigh = static_cast<DWORD>(pos >> 32);
+
+        DWORD got = 0;
+        if (!ReadFile(handle_, out + total, chunk, &got, &ov)) {
+            if (GetLastError() == ERROR_HANDLE_EOF) {
+                break;
+            }
+            return -1;
+        }
+#else
+        ssize_t got = pread(fd_, out + total, static_cast<size_t>(length - total), offset + total);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+#endif
+        if (got == 0) {
+            break;
+        }
+        total += got;
+    }
+
+    return total;
+}
+
+bool OutputFile::zeroRange(int64_t offset, int64_t length, bool sparse) const
+{
+    if (!isOpen() || offset < 0 || length < 0) {
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+
+#ifdef __linux__
+    // Punching keeps the file size, so a hole past the current end is a no-op
+    // and the final size comes from extendTo(); ZERO_RANGE allocates unwritten
+    // extents, which read as zeros without any data being written.
+    int mode = sparse ? FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE : FALLOC_FL_ZERO_RANGE;
+    int ret;
+    do {
+        syscalls_++;
+        ret = fallocate(fd_, mode, offset, length);
+    } while (ret != 0 && errno == EINTR);
+    if (ret == 0) {
+        return true;
+    }
+    if (errno != EOPNOTSUPP && errno != ENOSYS) {
+        return false;
+    }
+#endif
+    // Images are created empty, so a region nothing is written to already
+    // reads as zeros
+    if (sparse) {
+        return true;
+    }
+
+    static const uint8_t zeros[64 * 1024] = {};
+    while (length > 0) {
+        size_t chunk = static_cast<size_t>(std::min<int64_t>(length, sizeof(zeros)));
+        if (!writeAt(zeros, chunk, offset)) {
+            return false;
+        }
+        offset += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+bool OutputFile::extendTo(int64_t size) const
+{
+    if (!isOpen() || size < 0) {
+        return false;
+    }
+
+#ifdef _WIN32
+    LARGE_INTEGER current;
+    if (!GetFileSizeEx(handle_, &current)) {
+        return false;
+    }
+    if (current.QuadPart >= size) {
+        return true;
+    }
+    FILE_END_OF_FILE_INFO info;
+    info.EndOfFile.QuadPart = size;
+    syscalls_++;
+    return SetFileInformationByHandle(handle_, FileEndOfFileInfo, &info, sizeof(info)) != 0;
+#else
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        return false;
+    }
+    if (st.st_size >= size) {
+        return true;
+    }
+    syscalls_++;
+    return ftruncate(fd_, size) == 0;
+#endif
+}
+
+bool OutputFile::preallocate(int64_t size) const
+{
+    if (!isOpen() || size <= 0) {
+        return false;
+    }
+
+#if defined(_WIN32)
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = size;
+    syscalls_++;
+    return SetFileInformationByHandle(handle_, FileAllocationInfo, &info, sizeof(info)) != 0;
+#elif defined(__linux__)
+    // Mode 0 also sets the file size, so out-of-order writes never extend it
+    int ret;
+    do {
+        syscalls_++;
+        ret = fallocate(fd_, 0, 0, size);
+    } while (ret != 0 && errno == EINTR);
+    return ret == 0;
+#elif defined(__APPLE__)
+    // Prefer one contiguous run, settle for any allocation
+    fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, size, 0};
+    syscalls_++;
+    if (fcntl(fd_, F_PREALLOCATE, &store) != 0) {
+        store.fst_flags = F_ALLOCATEALL;
+        syscalls_++;
+        if (fcntl(fd_, F_PREALLOCATE, &store) != 0) {
+            return false;
+        }
+    }
+    return true;
+#else
+    // posix_fallocate() may emulate this by writing zeros, which is what
+    // preallocation is meant to avoid
+    return false;
+#endif
+}
+
+int64_t OutputFile::extentCount() const
+{
+#ifdef __linux__
+    if (!isOpen()) {
+        return -1;
+    }
+    // With no extent array the kernel only counts; SYNC settles delayed allocation
+    struct fiemap map;
+    memset(&map, 0, sizeof(map));
+    map.fm_length = FIEMAP_MAX_OFFSET;
+    map.fm_flags = FIEMAP_FLAG_SYNC;
+    if (ioctl(fd_, FS_IOC_FIEMAP, &map) != 0) {
+        return -1;
+    }
+    return map.fm_mapped_extents;
+#else
+    return -1;
+#endif
+}
+
+CopyPath OutputFile::copyRange(const PositionalFile& input,
+                               int64_t in_offset,
+                               int64_t length,
+                               int64_t offset) const
+{
+#ifdef __linux__
+    if (fd_ < 0 || input.fd() < 0 || in_offset < 0 || length <= 0 || offset < 0) {
+        return CopyPath::None;
+    }
+
+    // Cloning works in whole filesystem blocks; the kernel rejects the rest
+    if (in_offset % CLONE_ALIGNMENT == 0 && offset % CLONE_ALIGNMENT == 0 &&
+        length % CLONE_ALIGNMENT == 0) {
+        struct file_clone_range range;
+        range.src_fd = input.fd();
+        range.src_offset = static_cast<uint64_t>(in_offset);
+        range.src_length = static_cast<uint64_t>(length);
+        range.dest_offset = static_cast<uint64_t>(offset);
+        syscalls_++;
+        if (ioctl(fd_, FICLONERANGE, &range) == 0) {
+            return addWritten(length) ? CopyPath::Clone : CopyPath::None;
+        }
+    }
+
+    loff_t in_pos = in_offset;
+    loff_t out_pos = offset;
+    int64_t remaining = length;
+    while (remaining > 0) {
+        syscalls_++;
+        ssize_t copied =
+            copy_file_range(input.fd(), &in_pos, fd_, &out_pos, static_cast<size_t>(remaining), 0);
+        if (copied < 0 && errno == EINTR) {
+            continue;
+        }
+        // Unsupported, cross-filesystem, or the input ended early: whatever was
+        // copied is simply written again by the caller
+        if (copied <= 0) {
+            return CopyPath::None;
+        }
+        remaining -= copied;
+    }
+    return addWritten(length) ? CopyPath::CopyFileRange : CopyPath::None;
+#else
+    (void)input;
+    (void)in_offset;
+    (void)length;
+    (void)offset;
+    return CopyPath::None;
+#endif
+}
+
+bool OutputFile::sync() const
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    syscalls_++;
+    syncs_++;
+#ifdef _WIN32
+    return FlushFileBuffers(handle_) != 0;
+#elif defined(__linux__)
+    // Image contents are all that matter; the size is fixed by then
+    return fdatasync(fd_) == 0;
+#else
+    return fsync(fd_) == 0;
+#endif
+}
+
+void OutputFile::setSyncInterval(uint64_t interval)
+{
+    sync_interval_ = interval;
+}
+
+bool OutputFile::addWritten(uint64_t bytes) const
+{
+    if (sync_interval_ == 0 || unsynced_.fetch_add(bytes) + bytes < sync_interval_) {
+        return true;
+    }
+    // Several threads may cross the interval together; one of them syncs
+    if (unsynced_.exchange(0) < sync_interval_) {
+        return true;
+    }
+    return sync();
+}
+
+uint64_t OutputFile::syscallCount() const
+{
+    return syscalls_;
+}
+
+uint64_t OutputFile::syncCount() const
+{
+    return syncs_;
+}
+
+} // namespace payload_dumper
@@ -11,39 +11,174 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+typedef SRWLOCK http_lock_t;
+typedef CONDITION_VARIABLE http_cond_t;
+typedef HANDLE http_thread_t;
+#define http_lock_init(l)    InitializeSRWLock(l)
+#define http_lock_destroy(l) ((void)(l))
+#define http_lock(l)         AcquireSRWLockExclusive(l)
+#define http_unlock(l)       ReleaseSRWLockExclusive(l)
+#define http_cond_init(c)    InitializeConditionVariable(c)
+#define http_cond_destroy(c) ((void)(c))
+#define http_cond_wait(c, l) SleepConditionVariableSRW(c, l, INFINITE, 0)
+#define http_cond_signal(c)  WakeConditionVariable(c)
+#else
+#include <pthread.h>
+typedef pthread_mutex_t http_lock_t;
+typedef pthread_cond_t http_cond_t;
+typedef pthread_t http_thread_t;
+#define http_lock_init(l)    pthread_mutex_init(l, NULL)
+#define http_lock_destroy(l) pthread_mutex_destroy(l)
+#define http_lock(l)         pthread_mutex_lock(l)
+#define http_unlock(l)       pthread_mutex_unlock(l)
+#define http_cond_init(c)    pthread_cond_init(c, NULL)
+#define http_cond_destroy(c) pthread_cond_destroy(c)
+#define http_cond_wait(c, l) pthread_cond_wait(c, l)
+#define http_cond_signal(c)  pthread_cond_signal(c)
+#endif
+
 #define DEFAULT_USER_AGENT "KaluaBilla/payload-dumper-ungo"
 #define DEFAULT_TIMEOUT    600
-
+/* Idle easy handles kept for reuse; more are created while more requests run */
+#define HTTP_POOL_SIZE 64
+/* Connections per host: HTTP/2 multiplexes many ranges over each one, while
+ * HTTP/1.1 needs a connection for every request in flight */
+#define HTTP2_CONNECTIONS 2
+#define HTTP1_CONNECTIONS 16
+
+/* Completion of a queued request: the bytes stored in its buffer (short only
+ * at the end of the file) or -1; runs on the engine thread */
+typedef void (*http_callback_t)(void* userdata, int64_t result);
+
+typedef struct http_request {
+    uint64_t offset;
+    uint8_t* buffer;
+    size_t size;
+    size_t written;
+    http_callback_t callback;
+    void* userdata;
+    char range[64];
+    struct http_request* next;
+} http_request_t;
+
+/*
+ * Range requests are queued by any thread and run by one engine thread on a
+ * curl_multi handle, which multiplexes them over a few HTTP/2 connections or
+ * spreads them over a pool of HTTP/1.1 keep-alive connections. Easy handles
+ * are cloned from the configured template on demand and parked for reuse;
+ * DNS and TLS sessions are shared with the template through one CURLSH.
+ */
 typedef struct {
     char* url;
-    CURL* curl;
+    CURL* curl; /* template, only used to clone transfer handles */
+    CURLSH* share;
+    http_lock_t share_locks[CURL_LOCK_DATA_LAST];
+    CURLM* multi;
+    http_thread_t engine;
+    int engine_started;
+    int multiplexed;
+    http_lock_t lock; /* guards the fields below */
+    http_request_t* queue_head;
+    http_request_t* queue_tail;
+    int stopping;
+    int in_flight;
+    int max_in_flight;
+    CURL* idle[HTTP_POOL_SIZE];
+    int idle_count;
+    int handle_count;
     struct curl_slist* headers;
     uint64_t content_length;
     uint64_t bytes_downloaded;
+    char* etag;          /* from the probe, NULL if the server sent none */
+    char* last_modified;
     ziprand_http_config_t config;
 } http_io_ctx_t;
 
+/* Validators of the final response to the probe, across redirects */
 typedef struct {
-    uint8_t* buffer;
-    size_t size;
-    size_t written;
-} curl_buffer_t;
+    char* etag;
+    char* last_modified;
+} http_probe_t;
+
+/* A blocking read waiting for its request to complete */
+typedef struct {
+    http_io_ctx_t* http;
+    http_cond_t cond;
+    int done;
+    int64_t result;
+} http_waiter_t;
 
 static size_t http_write_callback(void* contents, size_t size, size_t nmemb, void* userp)
 {
     size_t total_size = size * nmemb;
-    curl_buffer_t* buf = userp;
+    http_request_t* req = userp;
 
     size_t to_copy = total_size;
-    if (buf->written + to_copy > buf->size)
-        to_copy = buf->size - buf->written;
+    if (req->written + to_copy > req->size)
+        to_copy = req->size - req->written;
 
-    memcpy(buf->buffer + buf->written, contents, to_copy);
-    buf->written += to_copy;
+    memcpy(req->buffer + req->written, contents, to_copy);
+    req->written += to_copy;
 
     return total_size;
 }
 
+/* Copies the value of a "Name: value" header line if the name matches */
+static char* http_header_value(const char* line, size_t length, const char* name)
+{
+    size_t name_length = strlen(name);
+    if (length <= name_length || line[name_length] != ':')
+        return NULL;
+    for (size_t i = 0; i < name_length; i++) {
+        char c = line[i];
+        if (c >= 'A' && c <= 'Z')
+            c = (char)(c - 'A' + 'a');
+        if (c != name[i])
+            return NULL;
+    }
+
+    const char* value = line + name_length + 1;
+    const char* end = line + length;
+    while (value < end && (*value == ' ' || *value == '\t'))
+        value++;
+    while (end > value && (end[-1] == '\r' || end[-1] == '\n' || end[-1] == ' '))
+        end--;
+
+    char* copy = malloc((size_t)(end - value) + 1);
+    if (copy) {
+        memcpy(copy, value, (size_t)(end - value));
+        copy[end - value] = '\0';
+    }
+    return copy;
+}
+
+static size_t http_probe_header_callback(char* buffer, size_t size, size_t nitems, void* userp)
+{
+    size_t length = size * nitems;
+    http_probe_t* probe = userp;
+
+    /* A new status line starts the headers of the next response */
+    if (length >= 5 && memcmp(buffer, "HTTP/", 5) == 0) {
+        free(probe->etag);
+        free(probe->last_modified);
+        probe->etag = NULL;
+        probe->last_modified = NULL;
+        return length;
+    }
+
+    char* value = http_header_value(buffer, length, "etag");
+    if (value) {
+        free(probe->etag);
+        probe->etag = value;
+    } else if ((value = http_header_value(buffer, length, "last-modified")) != NULL) {
+        free(probe->last_modified);
+        probe->last_modified = value;
+    }
+    return length;
+}
+
 ziprand_http_config_t ziprand_http_config_default(void)
 {
     ziprand_http_config_t config;
@@ -56,52 +191,262 @@ ziprand_http_config_t ziprand_http_config_default(void)
     return config;
 }
 
-static int64_t http_read(void* ctx, uint64_t offset, void* buffer, size_t size)
+static void http_share_lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userp)
 {
-    http_io_ctx_t* http = ctx;
+    http_io_ctx_t* http = userp;
+    (void)handle;
+    (void)access;
+    http_lock(&http->share_locks[data]);
+}
 
-    if (offset >= http->content_length)
+static void http_share_unlock(CURL* handle, curl_lock_data data, void* userp)
+{
+    http_io_ctx_t* http = userp;
+    (void)handle;
+    http_unlock(&http->share_locks[data]);
+}
+
+static CURL* http_acquire(http_io_ctx_t* http)
+{
+    CURL* curl = NULL;
+    http_lock(&http->lock);
+    if (http->idle_count > 0) {
+        curl = http->idle[--http->idle_count];
+    }
+    http_unlock(&http->lock);
+    if (curl)
+        return curl;
+
+    curl = curl_easy_duphandle(http->curl);
+    if (curl) {
+        /* Wait for a connection that can multiplex rather than open another */
+        if (http->multiplexed)
+            curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+        http_lock(&http->lock);
+        http->handle_count++;
+        http_unlock(&http->lock);
+    }
+    return curl;
+}
+
+static void http_release(http_io_ctx_t* http, CURL* curl, size_t downloaded)
+{
+    http_lock(&http->lock);
+    http->bytes_downloaded += downloaded;
+    if (http->idle_count < HTTP_POOL_SIZE) {
+        http->idle[http->idle_count++] = curl;
+        curl = NULL;
+    } else {
+        http->handle_count--;
+    }
+    http_unlock(&http->lock);
+
+    if (curl)
+        curl_easy_cleanup(curl);
+}
+
+static void http_complete(http_request_t* req, int64_t result)
+{
+    req->callback(req->userdata, result);
+    free(req);
+}
+
+/* Hands queued requests to the multi handle; runs on the engine thread */
+static void http_start_queued(http_io_ctx_t* http)
+{
+    http_lock(&http->lock);
+    http_request_t* req = http->queue_head;
+    http->queue_head = NULL;
+    http->queue_tail = NULL;
+    http_unlock(&http->lock);
+
+    while (req) {
+        http_request_t* next = req->next;
+        CURL* curl = http_acquire(http);
+        if (!curl) {
+            if (http->config.verbose) {
+                fprintf(stderr, "Failed to create HTTP handle\n");
+            }
+            http_complete(req, -1);
+            req = next;
+            continue;
+        }
+
+        curl_easy_setopt(curl, CURLOPT_RANGE, req->range);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, http_write_callback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, req);
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, req);
+        if (curl_multi_add_handle(http->multi, curl) != CURLM_OK) {
+            http_release(http, curl, 0);
+            http_complete(req, -1);
+            req = next;
+            continue;
+        }
+
+        http_lock(&http->lock);
+        http->in_flight++;
+        if (http->in_flight > http->max_in_flight)
+            http->max_in_flight = http->in_flight;
+        http_unlock(&http->lock);
+        req = next;
+    }
+}
+
+/* Completes every transfer the multi handle has finished */
+static void http_finish_done(http_io_ctx_t* http)
+{
+    CURLMsg* msg;
+    int left = 0;
+    while ((msg = curl_multi_info_read(http->multi, &left))) {
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+
+        CURL* curl = msg->easy_handle;
+        CURLcode res = msg->data.result;
+        http_request_t* req = NULL;
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char**)&req);
+
+        long http_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+        curl_multi_remove_handle(http->multi, curl);
+
+        http_lock(&http->lock);
+        http->in_flight--;
+        http_unlock(&http->lock);
+
+        int64_t result = (int64_t)req->written;
+        if (res != CURLE_OK) {
+            if (http->config.verbose) {
+                fprintf(stderr, "HTTP request failed: %s\n", curl_easy_strerror(res));
+            }
+            result = -1;
+        } else if (http_code != 206 && http_code != 200) {
+            if (http->config.verbose) {
+                fprintf(stderr, "HTTP error: %ld\n", http_code);
+            }
+            result = -1;
+        } else if (http_code == 200 && req->offset != 0) {
+            /* The server ignored the range and sent the file from the start */
+            if (http->config.verbose) {
+                fprintf(stderr, "HTTP server does not support range requests\n");
+            }
+            result = -1;
+        }
+        http_release(http, curl, res == CURLE_OK ? req->written : 0);
+        http_complete(req, result);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI http_engine(void* arg)
+#else
+static void* http_engine(void* arg)
+#endif
+{
+    http_io_ctx_t* http = arg;
+
+    while (1) {
+        http_start_queued(http);
+
+        int running = 0;
+        curl_multi_perform(http->multi, &running);
+        http_finish_done(http);
+
+        http_lock(&http->lock);
+        int idle = http->queue_head == NULL && http->in_flight == 0;
+        int stop = http->stopping && idle;
+        http_unlock(&http->lock);
+        if (stop)
+            break;
+
+        /* Sleeps until a socket is ready or a new request wakes it up */
+        curl_multi_poll(http->multi, NULL, 0, 1000, NULL);
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static int http_submit(http_io_ctx_t* http,
+                       uint64_t offset,
+                       void* buffer,
+                       size_t size,
+                       http_callback_t callback,
+                       void* userdata)
+{
+    if (offset >= http->content_length || size == 0) {
+        callback(userdata, 0);
         return 0;
+    }
 
     uint64_t remaining = http->content_length - offset;
     size_t to_read = size < remaining ? size : remaining;
 
-    if (to_read == 0)
-        return 0;
+    http_request_t* req = malloc(sizeof(http_request_t));
+    if (!req)
+        return -1;
 
-    char range[128];
-    snprintf(range,
-             sizeof(range),
+    req->offset = offset;
+    req->buffer = buffer;
+    req->size = to_read;
+    req->written = 0;
+    req->callback = callback;
+    req->userdata = userdata;
+    req->next = NULL;
+    snprintf(req->range,
+             sizeof(req->range),
              "%llu-%llu",
              (unsigned long long)offset,
              (unsigned long long)(offset + to_read - 1));
 
-    curl_easy_setopt(http->curl, CURLOPT_RANGE, range);
+    http_lock(&http->lock);
+    if (http->queue_tail) {
+        http->queue_tail->next = req;
+    } else {
+        http->queue_head = req;
+    }
+    http->queue_tail = req;
+    http_unlock(&http->lock);
 
-    curl_buffer_t buf = {.buffer = buffer, .size = to_read, .written = 0};
-    curl_easy_setopt(http->curl, CURLOPT_WRITEFUNCTION, http_write_callback);
-    curl_easy_setopt(http->curl, CURLOPT_WRITEDATA, &buf);
+    curl_multi_wakeup(http->multi);
+    return 0;
+}
 
-    CURLcode res = curl_easy_perform(http->curl);
-    if (res != CURLE_OK) {
-        if (http->config.verbose) {
-            fprintf(stderr, "HTTP request failed: %s\n", curl_easy_strerror(res));
-        }
-        return -1;
-    }
+static void http_wake_waiter(void* userdata, int64_t result)
+{
+    http_waiter_t* waiter = userdata;
+    http_lock(&waiter->http->lock);
+    waiter->result = result;
+    waiter->done = 1;
+    http_cond_signal(&waiter->cond);
+    http_unlock(&waiter->http->lock);
+}
 
-    long http_code = 0;
-    curl_easy_getinfo(http->curl, CURLINFO_RESPONSE_CODE, &http_code);
-    if (http_code != 206 && http_code != 200) {
-        if (http->config.verbose) {
-            fprintf(stderr, "HTTP error: %ld\n", http_code);
-        }
+static int64_t http_read(void* ctx, uint64_t offset, void* buffer, size_t size)
+{
+    http_io_ctx_t* http = ctx;
+
+    if (offset >= http->content_length || size == 0)
+        return 0;
+
+    http_waiter_t waiter = {.http = http, .done = 0, .result = -1};
+    http_cond_init(&waiter.cond);
+
+    if (http_submit(http, offset, buffer, size, http_wake_waiter, &waiter) != 0) {
+        http_cond_destroy(&waiter.cond);
         return -1;
     }
 
-    http->bytes_downloaded += buf.written;
+    http_lock(&http->lock);
+    while (!waiter.done)
+        http_cond_wait(&waiter.cond, &http->lock);
+    http_unlock(&http->lock);
 
-    return buf.written;
+    http_cond_destroy(&waiter.cond);
+    return waiter.result;
 }
 
 static int64_t http_size(void* ctx)
@@ -113,10 +458,35 @@ static int64_t http_size(void* ctx)
 static void http_close(void* ctx)
 {
     http_io_ctx_t* http = ctx;
-    if (http->headers)
-        curl_slist_free_all(http->headers);
+    if (http->engine_started) {
+        /* The engine drains whatever is still queued or in flight first */
+        http_lock(&http->lock);
+        http->stopping = 1;
+        http_unlock(&http->lock);
+        curl_multi_wakeup(http->multi);
+#ifdef _WIN32
+        WaitForSingleObject(http->engine, INFINITE);
+        CloseHandle(http->engine);
+#else
+        pthread_join(http->engine, NULL);
+#endif
+    }
+    if (http->multi)
+        curl_multi_cleanup(http->multi);
+    for (int i = 0; i < http->idle_count; i++)
+        curl_easy_cleanup(http->idle[i]);
     if (http->curl)
         curl_easy_cleanup(http->curl);
+    /* Only possible once no handle uses it any more */
+    if (http->share)
+        curl_share_cleanup(http->share);
+    if (http->headers)
+        curl_slist_free_all(http->headers);
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++)
+        http_lock_destroy(&http->share_locks[i]);
+    http_lock_destroy(&http->lock);
+    free(http->etag);
+    free(http->last_modified);
     free(http->url);
     free(http);
 }
@@ -162,6 +532,9 @@ ziprand_io_t* ziprand_io_http_ex(const char* url, const ziprand_http_config_t* c
         curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
     }
 
+    /* HTTP/2 where the server offers it over TLS, HTTP/1.1 otherwise */
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+
     struct curl_slist* headers = NULL;
     headers = curl_slist_append(headers, "Accept: */*");
     headers = curl_slist_append(headers, "Accept-Encoding: identity");
@@ -170,9 +543,20 @@ ziprand_io_t* ziprand_io_http_ex(const char* url, const ziprand_http_config_t* c
     curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
     curl_easy_setopt(curl, CURLOPT_HEADER, 0L);
 
+    http_probe_t probe = {NULL, NULL};
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, http_probe_header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &probe);
+
     CURLcode res = curl_easy_perform(curl);
+
+    /* Transfer handles are cloned from this one and must not inherit it */
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, NULL);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, NULL);
+
     if (res != CURLE_OK) {
         fprintf(stderr, "Failed to connect to %s: %s\n", url, curl_easy_strerror(res));
+        free(probe.etag);
+        free(probe.last_modified);
         curl_slist_free_all(headers);
         curl_easy_cleanup(curl);
         return NULL;
@@ -183,6 +567,8 @@ ziprand_io_t* ziprand_io_http_ex(const char* url, const ziprand_http_config_t* c
 
     if (content_length <= 0) {
         fprintf(stderr, "Could not determine content length for %s\n", url);
+        free(probe.etag);
+        free(probe.last_modified);
         curl_slist_free_all(headers);
         curl_easy_cleanup(curl);
         return NULL;
@@ -192,11 +578,16 @@ ziprand_io_t* ziprand_io_http_ex(const char* url, const ziprand_http_config_t* c
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
     if (http_code != 200 && http_code != 206) {
         fprintf(stderr, "HTTP error: %ld\n", http_code);
+        free(probe.etag);
+        free(probe.last_modified);
         curl_slist_free_all(headers);
         curl_easy_cleanup(curl);
         return NULL;
     }
 
+    long http_version = 0;
+    curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &http_version);
+
     if (cfg.verbose) {
         printf("Remote file size: %.2f MB\n", content_length / (1024.0 * 1024.0));
         printf("User-Agent: %s\n", ua);
@@ -206,8 +597,10 @@ ziprand_io_t* ziprand_io_http_ex(const char* url, const ziprand_http_config_t* c
     curl_easy_setopt(curl, CURLOPT_NOBODY, 0L);
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
 
-    http_io_ctx_t* http = malloc(sizeof(http_io_ctx_t));
+    http_io_ctx_t* http = calloc(1, sizeof(http_io_ctx_t));
     if (!http) {
+        free(probe.etag);
+        free(probe.last_modified);
         curl_slist_free_all(headers);
         curl_easy_cleanup(curl);
         return NULL;
@@ -218,14 +611,51 @@ ziprand_io_t* ziprand_io_http_ex(const char* url, const ziprand_http_config_t* c
     http->headers = headers;
     http->content_length = (uint64_t)content_length;
     http->bytes_downloaded = 0;
+    http->etag = probe.etag;
+    http->last_modified = probe.last_modified;
     http->config = cfg;
+    http_lock_init(&http->lock);
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++)
+        http_lock_init(&http->share_locks[i]);
+
+    /* Transfer handles resolve and resume TLS from what the probe learned */
+    http->share = curl_share_init();
+    if (http->share) {
+        curl_share_setopt(http->share, CURLSHOPT_LOCKFUNC, http_share_lock);
+        curl_share_setopt(http->share, CURLSHOPT_UNLOCKFUNC, http_share_unlock);
+        curl_share_setopt(http->share, CURLSHOPT_USERDATA, http);
+        curl_share_setopt(http->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(http->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_easy_setopt(curl, CURLOPT_SHARE, http->share);
+    }
+
+    http->multiplexed = http_version >= CURL_HTTP_VERSION_2_0;
+    long connections = http->multiplexed ? HTTP2_CONNECTIONS : HTTP1_CONNECTIONS;
+    http->multi = curl_multi_init();
+    if (!http->multi) {
+        fprintf(stderr, "Failed to initialize curl\n");
+        http_close(http);
+        return NULL;
+    }
+    curl_multi_setopt(http->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(http->multi, CURLMOPT_MAX_HOST_CONNECTIONS, connections);
+    curl_multi_setopt(http->multi, CURLMOPT_MAXCONNECTS, connections);
+
+#ifdef _WIN32
+    http->engine = CreateThread(NULL, 0, http_engine, http, 0, NULL);
+    http->engine_started = http->engine != NULL;
+#else
+    http->engine_started = pthread_create(&http->engine, NULL, http_engine, http) == 0;
+#endif
+    if (!http->engine_started) {
+        fprintf(stderr, "Failed to start HTTP engine\n");
+        http_close(http);
+        return NULL;
+    }
 
     ziprand_io_t* io = malloc(sizeof(ziprand_io_t));
     if (!io) {
-        free(http->url);
-        free(http);
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
+        http_close(http);
         return NULL;
     }
 
@@ -249,8 +679,56 @@ uint64_t ziprand_http_get_bytes_downloaded(ziprand_io_t* io)
 
     http_io_ctx_t* http = io->ctx;
     if (http->curl && http->url) {
-        return http->bytes_downloaded;
+        http_lock(&http->lock);
+        uint64_t downloaded = http->bytes_downloaded;
+        http_unlock(&http->lock);
+        return downloaded;
     }
 
     return 0;
+}
+
+int ziprand_http_get_handle_count(ziprand_io_t* io)
+{
+    if (!io || !io->ctx)
+        return 0;
+
+    http_io_ctx_t* http = io->ctx;
+    http_lock(&http->lock);
+    int count = http->handle_count;
+    http_unlock(&http->lock);
+    return count;
+}
+
+int ziprand_http_get_max_in_flight(ziprand_io_t* io)
+{
+    if (!io || !io->ctx)
+        return 0;
+
+    http_io_ctx_t* http = io->ctx;
+    http_lock(&http->lock);
+    int count = http->max_in_flight;
+    http_unlock(&http->lock);
+    return count;
+}
+
+const char* ziprand_http_get_validator(ziprand_io_t* io)
+{
+    if (!io || !io->ctx)
+        return NULL;
+
+    /* A weak ETag only promises equivalent content, not the same bytes */
+    http_io_ctx_t* http = io->ctx;
+    if (http->etag && strncmp(http->etag, "W/", 2) != 0)
+        return http->etag;
+    return http->last_modified;
+}
+
+int ziprand_http_is_multiplexed(ziprand_io_t* io)
+{
+    if (!io || !io->ctx)
+        return 0;
+
+    http_io_ctx_t* http = io->ctx;
+    return http->multiplexed;
 }
\ No newline at end of file
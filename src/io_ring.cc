@@ -0,0 +1,343 @@
+#include "io_ring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING
+#endif
+#endif
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace payload_dumper
+{
+
+IoRing::IoRing()
+    : ring_fd_(-1), entries_(0), queued_(0), in_flight_(0), sq_ptr_(nullptr), sq_size_(0),
+      cq_ptr_(nullptr), cq_size_(0), sqes_(nullptr), sqes_size_(0), sq_head_(nullptr),
+      sq_tail_(nullptr), sq_mask_(nullptr), sq_array_(nullptr), cq_head_(nullptr),
+      cq_tail_(nullptr), cq_mask_(nullptr), cqes_(nullptr), depth_samples_(0), depth_total_(0),
+      depth_max_(0)
+{
+}
+
+IoRing::~IoRing()
+{
+    release();
+}
+
+unsigned IoRing::capacity() const
+{
+    return entries_;
+}
+
+unsigned IoRing::inFlight() const
+{
+    return in_flight_ + queued_;
+}
+
+uint64_t IoRing::depthSamples() const
+{
+    return depth_samples_;
+}
+
+uint64_t IoRing::depthTotal() const
+{
+    return depth_total_;
+}
+
+unsigned IoRing::depthMax() const
+{
+    return depth_max_;
+}
+
+bool IoRing::queueRead(int fd, void* buffer, uint32_t length, uint64_t offset, uint64_t user_data)
+{
+#ifdef HAVE_IO_URING
+    return queue(IORING_OP_READ, fd, buffer, length, offset, user_data);
+#else
+    (void)fd, (void)buffer, (void)length, (void)offset, (void)user_data;
+    return false;
+#endif
+}
+
+bool IoRing::queueWrite(int fd,
+                        const void* buffer,
+                        uint32_t length,
+                        uint64_t offset,
+                        uint64_t user_data)
+{
+#ifdef HAVE_IO_URING
+    return queue(IORING_OP_WRITE, fd, buffer, length, offset, user_data);
+#else
+    (void)fd, (void)buffer, (void)length, (void)offset, (void)user_data;
+    return false;
+#endif
+}
+
+bool IoRing::submit()
+{
+    if (queued_ == 0) {
+        return true;
+    }
+    return enter(queued_, 0) >= 0;
+}
+
+#ifdef HAVE_IO_URING
+
+static int sysIoUringSetup(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int sysIoUringEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return static_cast<int>(
+        syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+static int sysIoUringRegister(int fd, unsigned opcode, void* arg, unsigned nr_args)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+bool IoRing::supported()
+{
+    // Decided once per process: seccomp filters (containers) and kernels older
+    // than 5.6 reject either the ring itself or the plain READ/WRITE opcodes.
+    static const bool result = [] {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = sysIoUringSetup(2, &params);
+        if (fd < 0) {
+            return false;
+        }
+
+        const unsigned nr_ops = 256;
+        std::vector<uint8_t> storage(sizeof(io_uring_probe) + nr_ops * sizeof(io_uring_probe_op));
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        bool ok = sysIoUringRegister(fd, IORING_REGISTER_PROBE, probe, nr_ops) == 0 &&
+                  probe->last_op >= IORING_OP_WRITE &&
+                  (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) &&
+                  (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+        close(fd);
+        return ok;
+    }();
+    return result;
+}
+
+bool IoRing::init(unsigned entries)
+{
+    release();
+
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = sysIoUringSetup(entries, &params);
+    if (fd < 0) {
+        return false;
+    }
+    ring_fd_ = fd;
+    entries_ = params.sq_entries;
+
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+
+    sq_ptr_ = mmap(nullptr,
+                   sq_size_,
+                   PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE,
+                   ring_fd_,
+                   IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+        sq_ptr_ = nullptr;
+        release();
+        return false;
+    }
+
+    if (single_mmap) {
+        cq_ptr_ = sq_ptr_;
+    } else {
+        cq_ptr_ = mmap(nullptr,
+                       cq_size_,
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE,
+                       ring_fd_,
+                       IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) {
+            cq_ptr_ = nullptr;
+            release();
+            return false;
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr,
+                 sqes_size_,
+                 PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE,
+                 ring_fd_,
+                 IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+        sqes_ = nullptr;
+        release();
+        return false;
+    }
+
+    uint8_t* sq = static_cast<uint8_t*>(sq_ptr_);
+    uint8_t* cq = static_cast<uint8_t*>(cq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = cq + params.cq_off.cqes;
+    return true;
+}
+
+void IoRing::release()
+{
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ && cq_ptr_ != sq_ptr_) {
+        munmap(cq_ptr_, cq_size_);
+    }
+    if (sq_ptr_) {
+        munmap(sq_ptr_, sq_size_);
+    }
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+    }
+    ring_fd_ = -1;
+    entries_ = 0;
+    queued_ = 0;
+    in_flight_ = 0;
+    sq_ptr_ = cq_ptr_ = sqes_ = nullptr;
+}
+
+bool IoRing::queue(uint8_t opcode,
+                   int fd,
+                   const void* buffer,
+                   uint32_t length,
+                   uint64_t offset,
+                   uint64_t user_data)
+{
+    // Never let more requests be outstanding than the CQ can hold
+    if (ring_fd_ < 0 || queued_ + in_flight_ >= entries_) {
+        return false;
+    }
+
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer);
+    sqe->len = length;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    queued_++;
+    return true;
+}
+
+int IoRing::enter(unsigned to_submit, unsigned min_complete)
+{
+    unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int ret;
+    do {
+        ret = sysIoUringEnter(ring_fd_, to_submit, min_complete, flags);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0) {
+        return -1;
+    }
+
+    unsigned submitted = static_cast<unsigned>(ret);
+    queued_ -= std::min(submitted, queued_);
+    in_flight_ += submitted;
+    if (submitted > 0) {
+        depth_samples_++;
+        depth_total_ += in_flight_;
+        depth_max_ = std::max(depth_max_, in_flight_);
+    }
+    return ret;
+}
+
+bool IoRing::wait(Completion& completion)
+{
+    while (true) {
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        if (head != tail) {
+            const io_uring_cqe* cqe = static_cast<const io_uring_cqe*>(cqes_) + (head & *cq_mask_);
+            completion.user_data = cqe->user_data;
+            completion.result = cqe->res;
+            __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+            in_flight_--;
+            return true;
+        }
+
+        if (in_flight_ == 0 && queued_ == 0) {
+            return false;
+        }
+        if (enter(queued_, 1) < 0) {
+            return false;
+        }
+    }
+}
+
+#else
+
+bool IoRing::supported()
+{
+    return false;
+}
+
+bool IoRing::init(unsigned entries)
+{
+    (void)entries;
+    return false;
+}
+
+void IoRing::release()
+{
+}
+
+bool IoRing::queue(uint8_t, int, const void*, uint32_t, uint64_t, uint64_t)
+{
+    return false;
+}
+
+int IoRing::enter(unsigned, unsigned)
+{
+    return -1;
+}
+
+bool IoRing::wait(Completion& completion)
+{
+    (void)completion;
+    return false;
+}
+
+#endif
+
+} // namespace payload_dumper
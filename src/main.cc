@@ -1,5 +1,7 @@
 #include "payload.hpp"
+#include "scratch_buffer.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <iomanip>
@@ -19,19 +21,56 @@ struct Options {
     int concurrency = 0;
     bool list_only = false;
     bool verify_hash = true;  // Enable verification by default
+    bool use_mmap = false;
+    bool show_stats = false;
+    bool huge_pages = false;
+    bool sparse = false;
+    bool preallocate = true;
+    payload_dumper::PipelineConfig pipeline;
+    payload_dumper::IoEngine io_engine = payload_dumper::IoEngine::Sync;
+    payload_dumper::ExtractOrder order = payload_dumper::ExtractOrder::Partition;
+    payload_dumper::SyncMode sync_mode = payload_dumper::SyncMode::None;
+    uint64_t prefetch_budget = payload_dumper::PREFETCH_BUDGET_BYTES;
+    std::string cache_dir;
+    uint64_t cache_size = payload_dumper::CACHE_SIZE_BYTES;
+    std::string mirror_path;
+    bool mirror_complete = false;
 };
 
 void printUsage(const char* program_name)
 {
-    std::cerr << "Usage: " << program_name << " [options] <input_file|url>\n\n"
+    std::cerr << "Usage: " << program_name << " [options] <input_file|url|->\n\n"
+              << "A payload.bin can also be streamed in on standard input (-) or a pipe.\n\n"
               << "Options:\n"
               << "  -l, --list              List partitions in payload.bin\n"
               << "  -o, --output DIR        Output directory\n"
               << "  -p, --partitions LIST   Extract only specified partitions (comma-separated)\n"
               << "  -c, --concurrency N     Number of extraction threads\n"
               << "  --no-verify             Disable SHA-256 hash verification\n"
+              << "  --mmap                  Memory-map a local payload.bin instead of reading it\n"
+              << "  --io-engine ENGINE      I/O engine for a local payload.bin: sync, io_uring\n"
+              << "  --order ORDER           Operation schedule: partition (largest image first)\n"
+              << "                          or input (sequential reads of payload.bin)\n"
+              << "  --pipeline R:D:W[:Q]    Run read, decode and write as separate stages with\n"
+              << "                          R reader, D decoder and W writer threads and Q\n"
+              << "                          operations queued between stages\n"
+              << "  --hugepages             Back large operation buffers with huge pages\n"
+              << "  --sparse                Leave zeroed regions and all-zero blocks of the\n"
+              << "                          images as holes\n"
+              << "  --no-preallocate        Do not reserve the full image size up front\n"
+              << "  --sync MODE             Flush images to disk: none, end (after each image)\n"
+              << "                          or periodic (every 64 MB written, and at the end)\n"
+              << "  --stats                 Print scheduler and I/O statistics after extraction\n"
 #ifdef HTTP_SUPPORT
               << "  -u, --user-agent STR    Custom User-Agent for HTTP requests\n"
+              << "  --prefetch MB           Memory for remote data fetched ahead of decoding\n"
+              << "                          (default 256, 0 disables prefetching)\n"
+              << "  --cache-dir DIR         Keep downloaded data in DIR and reuse it on later\n"
+              << "                          runs against the same file\n"
+              << "  --cache-size MB         Size of the cache directory (default 4096)\n"
+              << "  --mirror FILE           Save everything downloaded to a local copy of the\n"
+              << "                          remote file, resuming an earlier one\n"
+              << "  --mirror-complete       Also download the rest of the file in the background\n"
 #endif
               << "\n";
 }
@@ -48,6 +87,80 @@ bool parseArguments(int argc, char* argv[], Options& opts)
             opts.list_only = true;
         } else if (arg == "--no-verify") {
             opts.verify_hash = false;
+        } else if (arg == "--mmap") {
+            opts.use_mmap = true;
+        } else if (arg == "--stats") {
+            opts.show_stats = true;
+        } else if (arg == "--hugepages") {
+            opts.huge_pages = true;
+        } else if (arg == "--sparse") {
+            opts.sparse = true;
+        } else if (arg == "--no-preallocate") {
+            opts.preallocate = false;
+        } else if (arg == "--pipeline") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument\n";
+                return false;
+            }
+            std::vector<int> sizes;
+            std::stringstream ss(argv[++i]);
+            std::string size;
+            while (std::getline(ss, size, ':')) {
+                sizes.push_back(std::atoi(size.c_str()));
+            }
+            if ((sizes.size() != 3 && sizes.size() != 4) ||
+                std::any_of(sizes.begin(), sizes.begin() + 3, [](int n) { return n <= 0; })) {
+                std::cerr << "Error: " << arg << " expects READERS:DECODERS:WRITERS[:QUEUE]\n";
+                return false;
+            }
+            opts.pipeline.readers = sizes[0];
+            opts.pipeline.workers = sizes[1];
+            opts.pipeline.writers = sizes[2];
+            opts.pipeline.queue_depth = sizes.size() == 4 ? sizes[3] : 0;
+        } else if (arg == "--io-engine") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument\n";
+                return false;
+            }
+            std::string engine = argv[++i];
+            if (engine == "sync") {
+                opts.io_engine = payload_dumper::IoEngine::Sync;
+            } else if (engine == "io_uring") {
+                opts.io_engine = payload_dumper::IoEngine::IoUring;
+            } else {
+                std::cerr << "Error: unknown I/O engine " << engine << "\n";
+                return false;
+            }
+        } else if (arg == "--order") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument\n";
+                return false;
+            }
+            std::string order = argv[++i];
+            if (order == "partition") {
+                opts.order = payload_dumper::ExtractOrder::Partition;
+            } else if (order == "input") {
+                opts.order = payload_dumper::ExtractOrder::Input;
+            } else {
+                std::cerr << "Error: unknown order " << order << "\n";
+                return false;
+            }
+        } else if (arg == "--sync") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument\n";
+                return false;
+            }
+            std::string mode = argv[++i];
+            if (mode == "none") {
+                opts.sync_mode = payload_dumper::SyncMode::None;
+            } else if (mode == "end") {
+                opts.sync_mode = payload_dumper::SyncMode::End;
+            } else if (mode == "periodic") {
+                opts.sync_mode = payload_dumper::SyncMode::Periodic;
+            } else {
+                std::cerr << "Error: unknown sync mode " << mode << "\n";
+                return false;
+            }
         } else if (arg == "-o" || arg == "--output") {
             if (i + 1 >= argc) {
                 std::cerr << "Error: " << arg << " requires an argument\n";
@@ -78,8 +191,44 @@ bool parseArguments(int argc, char* argv[], Options& opts)
                 return false;
             }
             opts.user_agent = argv[++i];
+        } else if (arg == "--prefetch") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument\n";
+                return false;
+            }
+            int megabytes = std::atoi(argv[++i]);
+            if (megabytes < 0) {
+                std::cerr << "Error: " << arg << " expects a size in MB\n";
+                return false;
+            }
+            opts.prefetch_budget = static_cast<uint64_t>(megabytes) * 1024 * 1024;
+        } else if (arg == "--cache-dir") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument\n";
+                return false;
+            }
+            opts.cache_dir = argv[++i];
+        } else if (arg == "--cache-size") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument\n";
+                return false;
+            }
+            int megabytes = std::atoi(argv[++i]);
+            if (megabytes <= 0) {
+                std::cerr << "Error: " << arg << " expects a size in MB\n";
+                return false;
+            }
+            opts.cache_size = static_cast<uint64_t>(megabytes) * 1024 * 1024;
+        } else if (arg == "--mirror") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument\n";
+                return false;
+            }
+            opts.mirror_path = argv[++i];
+        } else if (arg == "--mirror-complete") {
+            opts.mirror_complete = true;
 #endif
-        } else if (arg[0] != '-') {
+        } else if (arg[0] != '-' || arg == "-") {
             opts.input_file = arg;
         } else {
             std::cerr << "Error: unknown option " << arg << "\n";
@@ -119,7 +268,7 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    if (!isUrl(opts.input_file) && !fs::exists(opts.input_file)) {
+    if (!isUrl(opts.input_file) && opts.input_file != "-" && !fs::exists(opts.input_file)) {
         std::cerr << "Error: file does not exist: " << opts.input_file << "\n";
         return 1;
     }
@@ -133,11 +282,31 @@ int main(int argc, char* argv[])
 
     if (isUrl(opts.input_file)) {
         std::cout << "Source: " << opts.input_file << " (remote)\n";
+    } else if (opts.input_file == "-") {
+        std::cout << "Source: standard input (stream)\n";
     } else {
         std::cout << "Source: " << opts.input_file << "\n";
     }
 
     payload_dumper::Payload payload(opts.input_file, opts.user_agent, opts.verify_hash);
+    payload.setUseMmap(opts.use_mmap);
+    payload.setIoEngine(opts.io_engine);
+    payload.setShowStats(opts.show_stats);
+    payload.setSparse(opts.sparse);
+    payload.setPreallocate(opts.preallocate);
+    payload.setOrder(opts.order);
+    payload.setSyncMode(opts.sync_mode);
+    payload.setPrefetchBudget(opts.prefetch_budget);
+#ifdef HTTP_SUPPORT
+    payload.setCache(opts.cache_dir, opts.cache_size);
+    if (opts.mirror_complete && opts.mirror_path.empty()) {
+        std::cerr << "Error: --mirror-complete requires --mirror\n";
+        return 1;
+    }
+    payload.setMirror(opts.mirror_path, opts.mirror_complete);
+#endif
+    payload.setPipeline(opts.pipeline);
+    payload_dumper::ScratchBuffer::setHugePages(opts.huge_pages);
 
     if (!payload.open()) {
         std::cerr << "Failed to open payload\n";
@@ -151,6 +320,11 @@ int main(int argc, char* argv[])
 
     if (opts.list_only) {
         payload.listPartitions();
+#ifdef HTTP_SUPPORT
+        if (!payload.finishMirror()) {
+            return 1;
+        }
+#endif
         return 0;
     }
 
@@ -169,7 +343,13 @@ int main(int argc, char* argv[])
     }
 
     std::cout << "Output directory: " << opts.output_dir << "\n";
-    std::cout << "Concurrency: " << opts.concurrency << " thread(s)\n";
+    if (opts.pipeline.enabled()) {
+        std::cout << "Pipeline: " << opts.pipeline.readers << " reader(s), "
+                  << opts.pipeline.workers << " decoder(s), " << opts.pipeline.writers
+                  << " writer(s)\n";
+    } else {
+        std::cout << "Concurrency: " << opts.concurrency << " thread(s)\n";
+    }
 
     auto start_time = std::chrono::steady_clock::now();
 
@@ -200,6 +380,9 @@ int main(int argc, char* argv[])
                       << " MB/s\n";
         }
     }
+    if (!payload.finishMirror()) {
+        return 1;
+    }
 #endif
 
     return 0;
@@ -0,0 +1,134 @@
+#include "partition_hasher.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace payload_dumper
+{
+
+// Read-back granularity when catching up on ranges that finished early
+static constexpr uint64_t READ_BACK_CHUNK = 1024 * 1024;
+
+PartitionHasher::PartitionHasher(const OutputFile& output,
+                                 uint64_t image_size,
+                                 uint64_t hold_budget)
+    : output_(output), image_size_(image_size), hold_budget_(hold_budget), frontier_(0),
+      read_back_(0), held_bytes_(0)
+{
+    sha256_init(&ctx_);
+}
+
+bool PartitionHasher::complete(uint64_t offset, const uint8_t* data, uint64_t length)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (offset + length <= frontier_) {
+        return true;
+    }
+    if (offset > frontier_) {
+        auto it = pending_.find(offset);
+        if (it != pending_.end()) {
+            if (it->second.length >= length) {
+                return true;
+            }
+            drop(it);
+        }
+        // Zeros need no copy; data past the budget is read back instead
+        Pending range{length, data == nullptr, nullptr};
+        if (data && held_bytes_ + length <= hold_budget_) {
+            range.copy.reset(new (std::nothrow) uint8_t[length]);
+            if (range.copy) {
+                memcpy(range.copy.get(), data, length);
+                held_bytes_ += length;
+            }
+        }
+        pending_.emplace(offset, std::move(range));
+        return true;
+    }
+
+    // Overlaps or touches the frontier: hash the new part straight from memory
+    uint64_t skip = frontier_ - offset;
+    if (data) {
+        sha256_update(&ctx_, data + skip, length - skip);
+    } else {
+        hashZeros(length - skip);
+    }
+    frontier_ = offset + length;
+
+    // Ranges that were waiting on this one are now contiguous
+    while (!pending_.empty() && pending_.begin()->first <= frontier_) {
+        auto it = pending_.begin();
+        const uint64_t end = it->first + it->second.length;
+        if (end > frontier_) {
+            const uint64_t ahead = frontier_ - it->first;
+            if (it->second.zeros) {
+                hashZeros(end - frontier_);
+            } else if (it->second.copy) {
+                sha256_update(&ctx_, it->second.copy.get() + ahead, end - frontier_);
+            } else if (!hashFromFile(end)) {
+                return false;
+            }
+            frontier_ = end;
+        }
+        drop(it);
+    }
+    return true;
+}
+
+bool PartitionHasher::finish(uint8_t digest[SHA256_DIGEST_SIZE])
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    pending_.clear();
+    held_bytes_ = 0;
+    if (frontier_ < image_size_ && !hashFromFile(image_size_)) {
+        return false;
+    }
+    sha256_final(&ctx_, digest);
+    return true;
+}
+
+void PartitionHasher::hashZeros(uint64_t length)
+{
+    static const uint8_t zeros[64 * 1024] = {};
+    while (length > 0) {
+        uint64_t chunk = std::min<uint64_t>(length, sizeof(zeros));
+        sha256_update(&ctx_, zeros, chunk);
+        length -= chunk;
+    }
+}
+
+void PartitionHasher::drop(std::map<uint64_t, Pending>::iterator it)
+{
+    if (it->second.copy) {
+        held_bytes_ -= it->second.length;
+    }
+    pending_.erase(it);
+}
+
+uint64_t PartitionHasher::readBackBytes() const
+{
+    return read_back_;
+}
+
+bool PartitionHasher::hashFromFile(uint64_t end)
+{
+    std::vector<uint8_t> buffer(std::min(READ_BACK_CHUNK, end - frontier_));
+    while (frontier_ < end) {
+        uint64_t length = std::min<uint64_t>(buffer.size(), end - frontier_);
+        int64_t got = output_.readAt(buffer.data(), frontier_, length);
+        if (got < 0) {
+            return false;
+        }
+        // Blocks never written read as zeros, as they would on the device
+        memset(buffer.data() + got, 0, length - got);
+        sha256_update(&ctx_, buffer.data(), length);
+        frontier_ += length;
+        read_back_ += length;
+    }
+    return true;
+}
+
+} // namespace payload_dumper
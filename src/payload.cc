@@ -1,7 +1,17 @@
 #define NOMINMAX
 #include "payload.hpp"
+#include "block_cache.hpp"
+#include "bounded_queue.hpp"
+#include "decoders.hpp"
+#include "io_ring.hpp"
+#include "partition_hasher.hpp"
+#include "prefetcher.hpp"
 #include "progress.hpp"
+#include "remote_mirror.hpp"
+#include "scratch_buffer.hpp"
 #include "sha256.h"
+#include "thread_pool.hpp"
+#include "zero_scan.hpp"
 
 #include <cstdint>
 #if defined(_MSC_VER)
@@ -11,21 +21,47 @@
 #endif
 #include <algorithm>
 #include <atomic>
-#include <bzlib.h>
+#include <chrono>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
-#include <lzma.h>
 #include <map>
+#include <memory>
 #include <queue>
 #include <sstream>
 #include <thread>
 #include <vector>
 #include <zstd.h>
 
+
 namespace payload_dumper
 {
 
+// Requests kept in flight per extraction thread by the io_uring engine
+static constexpr unsigned IO_RING_DEPTH = 64;
+// Output bytes per unit of work handed to an extraction thread
+static constexpr uint64_t OPERATION_BATCH_BYTES = 32ull * 1024 * 1024;
+// Blobs up to this size are gathered for multi-lane hashing; larger ones
+// already hash at full speed on their own
+static constexpr uint64_t MULTI_HASH_MAX_BYTES = 1024 * 1024;
+// Widest batch sha256_lanes() reports: the 8-lane AVX2 kernel
+static constexpr size_t MULTI_HASH_MAX_LANES = 8;
+// Upper bound for one read covering the blobs of consecutive operations
+static constexpr int64_t READ_SPAN_BYTES = 16ll * 1024 * 1024;
+// Consecutive operations decoded before their writes are issued together
+static constexpr int WINDOW_MAX_OPS = 8;
+static constexpr int64_t WINDOW_MAX_BYTES = 16ll * 1024 * 1024;
+// Buffers merged into one vectored write at most
+static constexpr size_t WRITE_BATCH_SEGMENTS = 64;
+// Output an image hasher copies from ranges finished ahead of its frontier;
+// beyond that it reads them back from the file
+static constexpr uint64_t HASH_HOLD_BYTES = 64ull * 1024 * 1024;
+// Remote blobs closer than this are fetched as one request, up to the
+// request size; the prefetch threads keep that many requests in flight
+static constexpr int64_t PREFETCH_MAX_GAP = 1024 * 1024;
+static constexpr int64_t PREFETCH_MAX_REQUEST = 16ll * 1024 * 1024;
+static constexpr int PREFETCH_THREADS = 8;
+
 static std::string formatBytes(uint64_t bytes)
 {
     const char* units[] = {"B", "KB", "MB", "GB", "TB"};
@@ -42,6 +78,22 @@ static std::string formatBytes(uint64_t bytes)
     return ss.str();
 }
 
+// Where the data of operations [begin, end) starts in the blob section;
+// operations without data (ZERO, DISCARD) sort to the front
+static uint64_t inputOffset(const chromeos_update_engine::PartitionUpdate& partition,
+                            int begin,
+                            int end)
+{
+    uint64_t offset = UINT64_MAX;
+    for (int i = begin; i < end; ++i) {
+        const auto& operation = partition.operations(i);
+        if (operation.data_length() > 0) {
+            offset = std::min<uint64_t>(offset, operation.data_offset());
+        }
+    }
+    return offset == UINT64_MAX ? 0 : offset;
+}
+
 bool Payload::isUrl(const std::string& path)
 {
     return (path.size() >= 7 && path.substr(0, 7) == "http://") ||
@@ -50,19 +102,28 @@ bool Payload::isUrl(const std::string& path)
 
 Payload::Payload(const std::string& filename, const std::string& user_agent, bool verify_hash)
     : filename_(filename), user_agent_(user_agent), verify_hash_(verify_hash), is_zip_(false), 
-      is_http_(false)
+      is_http_(false), is_stream_(false), use_mmap_(false), io_engine_(IoEngine::Sync)
 #ifdef ENABLE_ZIP
       ,
       zip_io_(nullptr), zip_archive_(nullptr), zip_file_(nullptr)
 #endif
+#ifdef HTTP_SUPPORT
       ,
-      metadata_size_(0), data_offset_(0), initialized_(false)
+      cache_max_bytes_(CACHE_SIZE_BYTES), cache_io_{}, mirror_complete_(false), mirror_io_{}
+#endif
+      ,
+      metadata_size_(0), data_offset_(0), initialized_(false), show_stats_(false), sparse_(false),
+      preallocate_(true), order_(ExtractOrder::Partition),
+      sync_mode_(SyncMode::None), prefetch_budget_(PREFETCH_BUDGET_BYTES)
 {
 
     is_http_ = isUrl(filename);
+    is_stream_ = !is_http_ && StreamFile::isStream(filename);
 
 #ifdef ENABLE_ZIP
-    if (is_http_) {
+    if (is_stream_) {
+        // ZIP needs random access to its central directory
+    } else if (is_http_) {
         is_zip_ = true;
     } else if (filename.size() >= 4 && filename.substr(filename.size() - 4) == ".zip") {
         is_zip_ = true;
@@ -80,9 +141,7 @@ Payload::~Payload()
         ziprand_close(zip_archive_);
     }
 #endif
-    if (file_.is_open()) {
-        file_.close();
-    }
+    file_.close();
 }
 
 bool Payload::open()
@@ -102,6 +161,14 @@ bool Payload::open()
                 std::cerr << "Failed to connect to URL\n";
                 return false;
             }
+            if (!cache_dir_.empty()) {
+                openCache();
+            }
+            if (!mirror_path_.empty() && !openMirror()) {
+                ziprand_io_free(zip_io_);
+                zip_io_ = nullptr;
+                return false;
+            }
         } else
 #endif
         {
@@ -112,7 +179,11 @@ bool Payload::open()
             }
         }
 
+#ifdef HTTP_SUPPORT
+        zip_archive_ = ziprand_open(mirror_ ? &mirror_io_ : cache_ ? &cache_io_ : zip_io_);
+#else
         zip_archive_ = ziprand_open(zip_io_);
+#endif
         if (!zip_archive_) {
             std::cerr << "Failed to parse ZIP archive\n";
             ziprand_io_free(zip_io_);
@@ -151,23 +222,114 @@ bool Payload::open()
             return false;
         }
 
+        if (use_mmap_) {
+            std::cerr << "Note: --mmap only applies to a raw payload.bin, ignoring\n";
+        }
         return true;
     }
 #endif
 
-    file_.open(filename_, std::ios::binary);
-    if (!file_.is_open()) {
+    if (is_stream_) {
+        if (!stream_.open(filename_)) {
+            std::cerr << "Failed to open stream: " << filename_ << "\n";
+            return false;
+        }
+        if (use_mmap_) {
+            std::cerr << "Note: --mmap does not apply to a stream, ignoring\n";
+        }
+        return true;
+    }
+
+    if (!file_.open(filename_)) {
         std::cerr << "Failed to open file: " << filename_ << "\n";
         return false;
     }
+
+    if (use_mmap_) {
+        if (file_.map()) {
+            file_.adviseSequential();
+        } else {
+            std::cerr << "Warning: failed to map " << filename_ << ", using regular reads\n";
+        }
+    }
     return true;
 }
 
+void Payload::setUseMmap(bool use_mmap)
+{
+    use_mmap_ = use_mmap;
+}
+
+void Payload::setIoEngine(IoEngine engine)
+{
+    io_engine_ = engine;
+}
+
+void Payload::setShowStats(bool show_stats)
+{
+    show_stats_ = show_stats;
+}
+
+void Payload::setSparse(bool sparse)
+{
+    sparse_ = sparse;
+}
+
+void Payload::setPreallocate(bool preallocate)
+{
+    preallocate_ = preallocate;
+}
+
+void Payload::setOrder(ExtractOrder order)
+{
+    order_ = order;
+}
+
+void Payload::setSyncMode(SyncMode mode)
+{
+    sync_mode_ = mode;
+}
+
+void Payload::setPrefetchBudget(uint64_t bytes)
+{
+    prefetch_budget_ = bytes;
+}
+
+void Payload::setPipeline(const PipelineConfig& config)
+{
+    pipeline_ = config;
+}
+
+const uint8_t* Payload::mappedBytes(int64_t offset, int64_t length) const
+{
+    const uint8_t* base = file_.data();
+    if (!base || offset < 0 || length < 0 || offset + length > file_.size()) {
+        return nullptr;
+    }
+    return base + offset;
+}
+
 int64_t Payload::readBytes(void* buffer, int64_t offset, int64_t length)
+{
+    if (prefetcher_) {
+        int64_t bytes_read = prefetcher_->read(buffer, offset, length);
+        if (bytes_read != 0) {
+            return bytes_read;
+        }
+    }
+    return readSource(buffer, offset, length);
+}
+
+int64_t Payload::readSource(void* buffer, int64_t offset, int64_t length)
 {
 #ifdef ENABLE_ZIP
     if (is_zip_) {
-        std::lock_guard<std::mutex> lock(file_mutex_);
+        // The HTTP backend runs each read on its own pooled connection, so
+        // remote ranges are fetched concurrently; a local archive is shared
+        std::unique_lock<std::mutex> lock(file_mutex_, std::defer_lock);
+        if (!is_http_) {
+            lock.lock();
+        }
         int64_t bytes_read = ziprand_fread_at(
             zip_file_, static_cast<uint64_t>(offset), buffer, static_cast<size_t>(length));
         if (bytes_read < 0) {
@@ -178,14 +340,27 @@ int64_t Payload::readBytes(void* buffer, int64_t offset, int64_t length)
     }
 #endif
 
-    std::lock_guard<std::mutex> lock(file_mutex_);
-    file_.seekg(offset);
-    if (!file_.good()) {
-        std::cerr << "Seek failed to offset " << offset << "\n";
+    if (is_stream_) {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        if (length > 0 && offset < stream_.position()) {
+            std::cerr << "Data at offset " << offset
+                      << " was already passed in the input stream\n";
+            return -1;
+        }
+        int64_t bytes_read = stream_.readAt(buffer, offset, length);
+        if (bytes_read < 0) {
+            std::cerr << "Read failed at offset " << offset << "\n";
+            return -1;
+        }
+        return bytes_read;
+    }
+
+    int64_t bytes_read = file_.readAt(buffer, offset, length);
+    if (bytes_read < 0) {
+        std::cerr << "Read failed at offset " << offset << "\n";
         return -1;
     }
-    file_.read(reinterpret_cast<char*>(buffer), length);
-    return file_.gcount();
+    return bytes_read;
 }
 
 bool Payload::readHeader()
@@ -261,9 +436,25 @@ bool Payload::init()
     metadata_size_ = header_.size + header_.manifest_len;
     data_offset_ = metadata_size_ + header_.metadata_signature_len;
 
+    if (io_engine_ == IoEngine::IoUring) {
+        if (is_zip_ || is_stream_ || file_.data()) {
+            std::cerr << "Note: io_uring needs a raw payload.bin without --mmap, using sync I/O\n";
+            io_engine_ = IoEngine::Sync;
+        } else if (pipeline_.enabled()) {
+            std::cerr << "Note: the pipeline has its own I/O threads, using sync I/O\n";
+            io_engine_ = IoEngine::Sync;
+        } else if (!IoRing::supported()) {
+            std::cerr << "Note: io_uring is not available on this system, using sync I/O\n";
+            io_engine_ = IoEngine::Sync;
+        }
+    }
+
     std::cout << "Payload version: " << header_.version << "\n";
     std::cout << "Number of partitions: " << manifest_.partitions_size() << "\n";
     std::cout << "Hash verification: " << (verify_hash_ ? "enabled" : "disabled") << "\n";
+    if (io_engine_ == IoEngine::IoUring) {
+        std::cout << "I/O engine: io_uring\n";
+    }
 
     initialized_ = true;
     return true;
@@ -281,6 +472,122 @@ void Payload::listPartitions() const
 }
 
 #ifdef HTTP_SUPPORT
+void Payload::setCache(const std::string& dir, uint64_t max_bytes)
+{
+    cache_dir_ = dir;
+    cache_max_bytes_ = max_bytes;
+}
+
+void Payload::openCache()
+{
+    // Without a validator a changed file could not be told from the cached one
+    const char* validator = ziprand_http_get_validator(zip_io_);
+    if (!validator) {
+        std::cerr << "Note: the server sends neither ETag nor Last-Modified, not caching\n";
+        return;
+    }
+
+    const uint64_t size = static_cast<uint64_t>(zip_io_->get_size(zip_io_->ctx));
+    cache_ = std::make_unique<BlockCache>([this](void* buffer, uint64_t offset, size_t length) {
+        return zip_io_->read(zip_io_->ctx, offset, buffer, length);
+    });
+    if (!cache_->open(cache_dir_, filename_ + "\n" + validator + "\n" + std::to_string(size),
+                      size,
+                      cache_max_bytes_)) {
+        std::cerr << "Warning: continuing without the cache\n";
+        cache_.reset();
+        return;
+    }
+
+    // The ZIP reader goes through the cache, which reads the HTTP io on misses
+    cache_io_.ctx = cache_.get();
+    cache_io_.read = [](void* ctx, uint64_t offset, void* buffer, size_t size) -> int64_t {
+        return static_cast<BlockCache*>(ctx)->read(buffer, offset, size);
+    };
+    cache_io_.get_size = [](void* ctx) -> int64_t {
+        return static_cast<int64_t>(static_cast<BlockCache*>(ctx)->size());
+    };
+    cache_io_.close = [](void*) {};
+}
+
+void Payload::setMirror(const std::string& path, bool complete)
+{
+    mirror_path_ = path;
+    mirror_complete_ = complete;
+}
+
+bool Payload::openMirror()
+{
+    const char* validator = ziprand_http_get_validator(zip_io_);
+    if (!validator) {
+        std::cerr << "Note: the server sends neither ETag nor Last-Modified, a local copy "
+                     "cannot be resumed later\n";
+    }
+
+    // Misses go to the cache if there is one, otherwise to the HTTP io
+    ziprand_io_t* source = cache_ ? &cache_io_ : zip_io_;
+    const uint64_t size = static_cast<uint64_t>(source->get_size(source->ctx));
+    mirror_ = std::make_unique<RemoteMirror>([source](void* buffer, uint64_t offset, size_t length) {
+        return source->read(source->ctx, offset, buffer, length);
+    });
+    if (!mirror_->open(mirror_path_, validator ? validator : "", size)) {
+        mirror_.reset();
+        return false;
+    }
+    if (mirror_->resumed()) {
+        std::cout << "Local copy: resuming " << mirror_path_ << ", "
+                  << formatBytes(mirror_->completeBytes()) << " of " << formatBytes(size)
+                  << " present\n";
+    }
+
+    mirror_io_.ctx = mirror_.get();
+    mirror_io_.read = [](void* ctx, uint64_t offset, void* buffer, size_t size) -> int64_t {
+        return static_cast<RemoteMirror*>(ctx)->read(buffer, offset, size);
+    };
+    mirror_io_.get_size = [](void* ctx) -> int64_t {
+        return static_cast<int64_t>(static_cast<RemoteMirror*>(ctx)->size());
+    };
+    mirror_io_.close = [](void*) {};
+
+    if (mirror_complete_) {
+        mirror_->startFill();
+    }
+    return true;
+}
+
+bool Payload::finishMirror()
+{
+    if (!mirror_) {
+        return true;
+    }
+
+    bool complete;
+    if (mirror_complete_) {
+        const uint64_t size = mirror_->size();
+        if (mirror_->completeBytes() < size) {
+            std::cout << "Completing local copy: " << formatBytes(mirror_->completeBytes())
+                      << " of " << formatBytes(size) << " present...\n";
+        }
+        complete = mirror_->finishFill();
+    } else {
+        complete = mirror_->completeBytes() == mirror_->size();
+    }
+
+    uint64_t present = mirror_->completeBytes();
+    uint64_t size = mirror_->size();
+    if (!mirror_->close()) {
+        std::cerr << "Failed to finish local copy: " << mirror_path_ << "\n";
+        return false;
+    }
+    if (complete) {
+        std::cout << "Local copy complete: " << mirror_path_ << "\n";
+    } else {
+        std::cout << "Local copy: " << formatBytes(present) << " of " << formatBytes(size)
+                  << " in " << mirror_path_ << ", rerun to continue it\n";
+    }
+    return !mirror_complete_ || complete;
+}
+
 uint64_t Payload::getBytesDownloaded() const
 {
     if (is_http_ && zip_io_) {
@@ -314,6 +621,19 @@ public:
         return std::string(hex);
     }
 
+    // How many independent buffers hashMany() processes at once; above one
+    // it pays to gather several small blobs before hashing
+    static size_t lanes() {
+        return sha256_lanes();
+    }
+
+    static void hashMany(const uint8_t* const* data,
+                         const size_t* sizes,
+                         size_t count,
+                         uint8_t (*digests)[SHA256_DIGEST_SIZE]) {
+        sha256_many(data, sizes, count, digests);
+    }
+
 private:
     SHA256_CTX ctx_;
 };
@@ -347,189 +667,1139 @@ private:
     SHA256Hasher* hasher_;
 };
 
-bool Payload::extractPartition(const chromeos_update_engine::PartitionUpdate& partition,
-                               const std::string& output_path,
-                               ProgressTracker* progress_tracker)
+bool Payload::decodeOperation(const chromeos_update_engine::InstallOperation& operation,
+                              const std::string& name,
+                              const uint8_t* input,
+                              size_t input_size,
+                              const uint8_t* input_digest,
+                              DecoderCache& decoders,
+                              ScratchBuffer& decompressed_data,
+                              const uint8_t** out_data,
+                              size_t* out_size)
 {
-    std::string name = partition.partition_name();
+    // The output is scattered over all destination extents in order
+    int64_t expected_size = 0;
+    for (const auto& extent : operation.dst_extents()) {
+        expected_size += extent.num_blocks() * BLOCK_SIZE;
+    }
+
+    // Initialize SHA-256 hasher for verification, unless the caller already
+    // hashed the input together with other operations
+    const bool hash_input = verify_hash_ && !input_digest;
+    SHA256Hasher hasher;
+    TeeReader tee_reader(input, input_size, hash_input ? &hasher : nullptr);
+
+    // REPLACE data is written straight from the input blob
+    const uint8_t* output_data = nullptr;
+    size_t output_size = 0;
+    bool zero_range = false;
+    decompressed_data.clear();
+
+    switch (operation.type()) {
+    case chromeos_update_engine::InstallOperation_Type_REPLACE: {
+        output_data = input;
+        output_size = input_size;
+        // Update hash with all data
+        if (hash_input) {
+            hasher.update(input, input_size);
+        }
+        break;
+    }
+
+    case chromeos_update_engine::InstallOperation_Type_REPLACE_XZ: {
+        decompressed_data.resize(expected_size);
+
+        // Hash the compressed data (input)
+        if (hash_input) {
+            hasher.update(input, input_size);
+        }
+
+        size_t produced = 0;
+        if (!decoders.decodeXz(input,
+                               input_size,
+                               decompressed_data.data(),
+                               decompressed_data.size(),
+                               &produced)) {
+            std::cerr << "\nXZ decompression failed for " << name << "\n";
+            return false;
+        }
+        decompressed_data.resize(produced);
+        break;
+    }
+
+    case chromeos_update_engine::InstallOperation_Type_REPLACE_BZ: {
+        decompressed_data.resize(expected_size);
+
+        // Hash the compressed data (input)
+        if (hash_input) {
+            hasher.update(input, input_size);
+        }
+
+        size_t produced = 0;
+        if (!decoders.decodeBz2(input,
+                                input_size,
+                                decompressed_data.data(),
+                                decompressed_data.size(),
+                                &produced)) {
+            std::cerr << "\nBZ2 decompression failed for " << name << "\n";
+            return false;
+        }
+        decompressed_data.resize(produced);
+        break;
+    }
+
+    case chromeos_update_engine::InstallOperation_Type_ZSTD: {
+        unsigned long long dest_size = ZSTD_getFrameContentSize(input, input_size);
+        if (dest_size == ZSTD_CONTENTSIZE_UNKNOWN || dest_size == ZSTD_CONTENTSIZE_ERROR) {
+            dest_size = expected_size;
+        }
+        decompressed_data.resize(dest_size);
+        
+        // Hash the compressed data (input)
+        if (hash_input) {
+            hasher.update(input, input_size);
+        }
+
+        size_t produced = 0;
+        if (!decoders.decodeZstd(input,
+                                 input_size,
+                                 decompressed_data.data(),
+                                 decompressed_data.size(),
+                                 &produced)) {
+            std::cerr << "\nZSTD decompression failed for " << name << "\n";
+            return false;
+        }
+        decompressed_data.resize(produced);
+        break;
+    }
+
+    case chromeos_update_engine::InstallOperation_Type_ZERO:
+    case chromeos_update_engine::InstallOperation_Type_DISCARD: {
+        // Nothing to decode or hash; the writer zeroes the range in the file.
+        // DISCARDed blocks have no defined contents, zeros are as good as any.
+        zero_range = true;
+        output_size = expected_size;
+        break;
+    }
 
-    std::ofstream output(output_path, std::ios::binary);
-    if (!output.is_open()) {
-        std::cerr << "\nFailed to create output file: " << output_path << "\n";
+    default:
+        std::cerr << "\nUnhandled operation type for " << name << "\n";
         return false;
     }
 
-    int total_ops = partition.operations_size();
-    int completed_ops = 0;
+    if (!output_data && !zero_range) {
+        output_data = decompressed_data.data();
+        output_size = decompressed_data.size();
+    }
 
-    if (progress_tracker) {
-        progress_tracker->update(name, 0, total_ops);
+    if (output_size != static_cast<size_t>(expected_size)) {
+        std::cerr << "\nSize mismatch for " << name << "\n";
+        return false;
     }
 
-    for (const auto& operation : partition.operations()) {
-        if (operation.dst_extents_size() == 0) {
-            std::cerr << "\nInvalid operation for " << name << "\n";
+    // Verify SHA-256 hash if enabled and hash is present
+    if (verify_hash_ && operation.has_data_sha256_hash() && 
+        !operation.data_sha256_hash().empty()) {
+        
+        uint8_t calculated_hash[SHA256_DIGEST_SIZE];
+        if (input_digest) {
+            memcpy(calculated_hash, input_digest, SHA256_DIGEST_SIZE);
+        } else {
+            hasher.finalize(calculated_hash);
+        }
+
+        const std::string& expected_hash_bytes = operation.data_sha256_hash();
+        
+        if (expected_hash_bytes.size() == SHA256_DIGEST_SIZE) {
+            if (memcmp(calculated_hash, expected_hash_bytes.data(), SHA256_DIGEST_SIZE) != 0) {
+                // Convert hashes to hex for error message
+                char calculated_hex[65];
+                sha256_to_hex(calculated_hash, calculated_hex);
+                
+                char expected_hex[65];
+                sha256_to_hex(reinterpret_cast<const uint8_t*>(expected_hash_bytes.data()), 
+                              expected_hex);
+                
+                std::cerr << "\n✗ Hash verification failed for " << name << "\n";
+                std::cerr << "  Expected: " << expected_hex << "\n";
+                std::cerr << "  Got:      " << calculated_hex << "\n";
+                return false;
+            }
+        }
+    }
+
+    *out_data = output_data;
+    *out_size = output_size;
+    return true;
+}
+
+// Per-thread state reused by every batch a pool thread runs
+struct Payload::WorkerContext {
+    std::unique_ptr<IoRing> ring;
+    DecoderCache decoders;
+    // Contiguous run of operation blobs read with one call; inputs are views into it
+    ScratchBuffer read_buffer;
+    // Output buffers of the operations in one window
+    std::vector<ScratchBuffer> outputs;
+    // Blob of a REPLACE operation the kernel failed to copy
+    ScratchBuffer copy_fallback;
+    std::vector<ScratchBuffer> slot_buffers;
+};
+
+// State shared by all batches of one partition
+struct Payload::PartitionJob {
+    const chromeos_update_engine::PartitionUpdate* partition = nullptr;
+    std::string name;
+    OutputFile output;
+    // Set when the manifest carries a hash of the whole image
+    std::unique_ptr<PartitionHasher> hasher;
+    std::atomic<int> completed_ops{0};
+    std::atomic<bool> failed{false};
+    // Bytes left as holes in sparse mode: ZERO/DISCARD ranges, zero data blocks
+    std::atomic<uint64_t> hole_bytes{0};
+    std::atomic<uint64_t> zero_block_bytes{0};
+    // Extents written and the write calls they took after coalescing
+    std::atomic<uint64_t> extents_written{0};
+    std::atomic<uint64_t> write_calls{0};
+    // Of those, writes submitted through io_uring rather than issued as syscalls
+    std::atomic<uint64_t> ring_writes{0};
+    // Operation blobs fetched from the payload and the reads that fetched them
+    std::atomic<uint64_t> blobs_read{0};
+    std::atomic<uint64_t> read_calls{0};
+    // REPLACE bytes reflinked, moved by copy_file_range, or passed through memory
+    std::atomic<uint64_t> cloned_bytes{0};
+    std::atomic<uint64_t> kernel_copied_bytes{0};
+    std::atomic<uint64_t> replace_buffered_bytes{0};
+    // Cleared once the kernel has refused to copy into this image
+    std::atomic<bool> kernel_copy{true};
+
+    // Called once data has been written at offset (null data: zeros); feeds the image hash
+    bool written(int64_t offset, const uint8_t* data, size_t size)
+    {
+        if (hasher && !hasher->complete(offset, data, size)) {
+            std::cerr << "\nFailed to read back output of " << name << " for hashing\n";
             return false;
         }
+        return true;
+    }
 
-        const auto& extent = operation.dst_extents(0);
-        int64_t data_offset = data_offset_ + operation.data_offset();
-        int64_t data_length = operation.data_length();
-        output.seekp(extent.start_block() * BLOCK_SIZE);
-        int64_t expected_size = extent.num_blocks() * BLOCK_SIZE;
+    // Scatters one operation's output over its destination extents. Null data
+    // (ZERO, DISCARD) zeroes the ranges right away; everything else goes into
+    // the batch, and in sparse mode all-zero blocks are left out of it.
+    bool store(const chromeos_update_engine::InstallOperation& operation,
+               const uint8_t* data,
+               size_t size,
+               bool sparse,
+               WriteBatch& batch);
+
+    // Has the kernel copy a REPLACE blob at input_offset of the payload into
+    // the destination extents; data is the mapped blob, if any, for the image
+    // hash. *copied stays false when the caller has to write the blob itself.
+    bool copy(const chromeos_update_engine::InstallOperation& operation,
+              const PositionalFile& input,
+              int64_t input_offset,
+              const uint8_t* data,
+              bool* copied);
+};
 
-        std::vector<uint8_t> compressed_data(data_length);
-        if (readBytes(compressed_data.data(), data_offset, data_length) != data_length) {
+// Writes gathered by one thread. A segment that starts where the previous one
+// ended joins the same vectored write, so the extents of consecutive
+// operations go out together. Buffers must stay valid until flush().
+struct Payload::WriteBatch {
+    PartitionJob* job = nullptr;
+    std::vector<WriteSegment> segments;
+    std::vector<int64_t> offsets;
+    int64_t end = 0;
+
+    bool add(PartitionJob& target, int64_t offset, const uint8_t* data, size_t size)
+    {
+        if (!segments.empty() &&
+            (job != &target || offset != end || segments.size() >= WRITE_BATCH_SEGMENTS)) {
+            if (!flush()) {
+                return false;
+            }
+        }
+        job = &target;
+        segments.push_back({data, size});
+        offsets.push_back(offset);
+        end = offset + static_cast<int64_t>(size);
+        return true;
+    }
+
+    bool flush()
+    {
+        if (segments.empty()) {
+            return true;
+        }
+
+        bool ok = job->output.writeAt(segments.data(), segments.size(), offsets.front());
+        if (!ok) {
+            std::cerr << "\nFailed to write output for " << job->name << "\n";
+        }
+        job->write_calls++;
+        job->extents_written += segments.size();
+        // Only hash once the data is in the file; the hasher may read it back
+        for (size_t i = 0; ok && i < segments.size(); ++i) {
+            ok = job->written(offsets[i], static_cast<const uint8_t*>(segments[i].data),
+                              segments[i].size);
+        }
+        segments.clear();
+        offsets.clear();
+        return ok;
+    }
+};
+
+bool Payload::PartitionJob::copy(const chromeos_update_engine::InstallOperation& operation,
+                                  const PositionalFile& input,
+                                  int64_t input_offset,
+                                  const uint8_t* data,
+                                  bool* copied)
+{
+    *copied = false;
+    const uint64_t size = operation.data_length();
+    uint64_t pos = 0;
+    uint64_t cloned = 0;
+    for (const auto& extent : operation.dst_extents()) {
+        const int64_t offset = extent.start_block() * BLOCK_SIZE;
+        const uint64_t length = std::min<uint64_t>(extent.num_blocks() * BLOCK_SIZE, size - pos);
+        CopyPath path = output.copyRange(input, input_offset + pos, length, offset);
+        if (path == CopyPath::None) {
+            // Whatever did get copied is overwritten by the caller's fallback
+            kernel_copy = false;
+            return true;
+        }
+        if (path == CopyPath::Clone) {
+            cloned += length;
+        }
+        pos += length;
+    }
+
+    *copied = true;
+    cloned_bytes += cloned;
+    kernel_copied_bytes += pos - cloned;
+    pos = 0;
+    for (const auto& extent : operation.dst_extents()) {
+        const int64_t offset = extent.start_block() * BLOCK_SIZE;
+        const uint64_t length = std::min<uint64_t>(extent.num_blocks() * BLOCK_SIZE, size - pos);
+        extents_written++;
+        if (!written(offset, data ? data + pos : nullptr, length)) {
+            return false;
+        }
+        pos += length;
+    }
+    return true;
+}
+
+bool Payload::PartitionJob::store(const chromeos_update_engine::InstallOperation& operation,
+                                  const uint8_t* data,
+                                  size_t size,
+                                  bool sparse,
+                                  WriteBatch& batch)
+{
+    if (operation.type() == chromeos_update_engine::InstallOperation_Type_REPLACE) {
+        replace_buffered_bytes += size;
+    }
+
+    size_t pos = 0;
+    for (const auto& extent : operation.dst_extents()) {
+        const int64_t offset = extent.start_block() * BLOCK_SIZE;
+        const size_t length = std::min<size_t>(extent.num_blocks() * BLOCK_SIZE, size - pos);
+
+        if (!data) {
+            if (!output.zeroRange(offset, length, sparse)) {
+                std::cerr << "\nFailed to write output for " << name << "\n";
+                return false;
+            }
+            if (sparse) {
+                hole_bytes += length;
+            }
+            if (!written(offset, nullptr, length)) {
+                return false;
+            }
+        } else if (sparse) {
+            // Queue the runs of blocks that hold data; the image starts out
+            // empty, so the zero blocks in between are holes already
+            const uint8_t* extent_data = data + pos;
+            size_t run_start = 0;
+            bool in_run = false;
+            for (size_t block = 0; block < length; block += BLOCK_SIZE) {
+                size_t block_size = std::min<size_t>(BLOCK_SIZE, length - block);
+                if (!isAllZero(extent_data + block, block_size)) {
+                    if (!in_run) {
+                        run_start = block;
+                        in_run = true;
+                    }
+                    continue;
+                }
+                zero_block_bytes += block_size;
+                if (in_run) {
+                    if (!batch.add(*this,
+                                   offset + run_start,
+                                   extent_data + run_start,
+                                   block - run_start)) {
+                        return false;
+                    }
+                    in_run = false;
+                }
+                if (!written(offset + block, nullptr, block_size)) {
+                    return false;
+                }
+            }
+            if (in_run &&
+                !batch.add(*this, offset + run_start, extent_data + run_start, length - run_start)) {
+                return false;
+            }
+        } else if (!batch.add(*this, offset, data + pos, length)) {
+            return false;
+        }
+
+        pos += length;
+    }
+    return true;
+}
+
+void Payload::reportProgress(PartitionJob& job, int count, ProgressTracker* progress_tracker)
+{
+    int total_ops = job.partition->operations_size();
+    int completed_ops = job.completed_ops.fetch_add(count) + count;
+
+    // Redraw about every 5%, whichever batch happens to cross the step
+    int step = total_ops / 20 + 1;
+    if (progress_tracker &&
+        (completed_ops == total_ops || completed_ops / step != (completed_ops - count) / step)) {
+        progress_tracker->update(job.name, completed_ops, total_ops);
+    }
+}
+
+void Payload::failJob(PartitionJob& job)
+{
+    if (job.failed.exchange(true) || !prefetcher_) {
+        return;
+    }
+    // Its remaining operations are skipped, so nobody reads their data
+    std::vector<RangePrefetcher::Range> ranges;
+    for (const auto& operation : job.partition->operations()) {
+        if (operation.data_length() > 0) {
+            ranges.push_back({data_offset_ + static_cast<int64_t>(operation.data_offset()),
+                              static_cast<int64_t>(operation.data_length())});
+        }
+    }
+    prefetcher_->discard(ranges);
+}
+
+bool Payload::extractOperations(PartitionJob& job,
+                                int begin,
+                                int end,
+                                ProgressTracker* progress_tracker,
+                                WorkerContext& context)
+{
+    const auto& partition = *job.partition;
+    const std::string& name = job.name;
+    const int total_ops = partition.operations_size();
+    const bool mapped = file_.data() != nullptr;
+
+    // Operations are handled in windows of consecutive ops: their outputs stay
+    // around until the window's writes are issued, so adjacent extents merge
+    // into one vectored write. With multi-lane SHA-256 the small blobs of a
+    // window are also hashed side by side before decoding.
+    const size_t lanes = verify_hash_ ? std::min(SHA256Hasher::lanes(), MULTI_HASH_MAX_LANES) : 1;
+    auto multiHashable = [&](int op_index) {
+        const auto& operation = partition.operations(op_index);
+        return lanes > 1 && operation.data_length() <= MULTI_HASH_MAX_BYTES &&
+               operation.data_sha256_hash().size() == SHA256_DIGEST_SIZE;
+    };
+    if (context.outputs.size() < WINDOW_MAX_OPS) {
+        context.outputs.resize(WINDOW_MAX_OPS);
+    }
+    WriteBatch batch;
+
+    // REPLACE blobs of a raw payload.bin are copied by the kernel when no
+    // bytes are needed in memory: hashes come from the mapping or are not
+    // checked, and there are no zero blocks to find for sparse output. A blob
+    // that does not fill its dst_extents exactly is decoded instead, so the
+    // size mismatch is reported there
+    const bool kernel_copy = file_.fd() >= 0 && !sparse_ && (mapped || !verify_hash_);
+    auto kernelCopyable = [&](int op_index) {
+        const auto& operation = partition.operations(op_index);
+        if (!kernel_copy || !job.kernel_copy || operation.data_length() == 0 ||
+            operation.type() != chromeos_update_engine::InstallOperation_Type_REPLACE) {
+            return false;
+        }
+        uint64_t extents_size = 0;
+        for (const auto& extent : operation.dst_extents()) {
+            extents_size += extent.num_blocks() * BLOCK_SIZE;
+        }
+        return operation.data_length() == extents_size;
+    };
+
+    // Without a mapping, blobs that follow each other in the payload are read
+    // together into one span and the operations get views into it
+    int64_t span_begin = 0;
+    int64_t span_end = 0;
+    auto loadSpan = [&](int first) {
+        span_begin = data_offset_ + partition.operations(first).data_offset();
+        span_end = span_begin + partition.operations(first).data_length();
+        int blobs = 1;
+        for (int i = first + 1; i < end; ++i) {
+            const auto& next = partition.operations(i);
+            if (next.data_length() == 0) {
+                continue;
+            }
+            if (kernelCopyable(i) ||
+                data_offset_ + static_cast<int64_t>(next.data_offset()) != span_end ||
+                span_end + static_cast<int64_t>(next.data_length()) - span_begin > READ_SPAN_BYTES) {
+                break;
+            }
+            span_end += next.data_length();
+            blobs++;
+        }
+
+        int64_t length = span_end - span_begin;
+        if (readBytes(context.read_buffer.resize(length), span_begin, length) != length) {
             std::cerr << "\nFailed to read data for " << name << "\n";
             return false;
         }
+        job.read_calls++;
+        job.blobs_read += blobs;
+        return true;
+    };
 
-        // Initialize SHA-256 hasher for verification
-        SHA256Hasher hasher;
-        TeeReader tee_reader(compressed_data.data(), compressed_data.size(), 
-                             verify_hash_ ? &hasher : nullptr);
+    for (int window_begin = begin; window_begin < end;) {
+        const uint8_t* inputs[WINDOW_MAX_OPS];
+        size_t input_sizes[WINDOW_MAX_OPS];
+        bool copies[WINDOW_MAX_OPS];
+        int window_end = window_begin;
+        int64_t window_bytes = 0;
+        while (window_end < end && window_end - window_begin < WINDOW_MAX_OPS) {
+            const auto& operation = partition.operations(window_end);
+            int64_t data_offset = data_offset_ + operation.data_offset();
+            int64_t data_length = operation.data_length();
+            if (window_end > window_begin && window_bytes + data_length > WINDOW_MAX_BYTES) {
+                break;
+            }
 
-        std::vector<uint8_t> decompressed_data;
+            // With a mapping the blob is used in place; otherwise it is a view
+            // into the span, unless the kernel copies it without reading it
+            const uint8_t* input = nullptr;
+            const bool copy = kernelCopyable(window_end);
+            if (data_length == 0 || (copy && !mapped)) {
+                // ZERO and DISCARD carry no data
+            } else if (mapped) {
+                input = mappedBytes(data_offset, data_length);
+                if (!input) {
+                    std::cerr << "\nData for " << name << " lies outside the payload\n";
+                    return false;
+                }
+                if (window_end + 1 < total_ops) {
+                    const auto& next = partition.operations(window_end + 1);
+                    file_.adviseWillNeed(data_offset_ + next.data_offset(), next.data_length());
+                }
+            } else {
+                if (data_offset < span_begin || data_offset + data_length > span_end) {
+                    // Earlier operations of the window still point into the span
+                    if (window_end > window_begin) {
+                        break;
+                    }
+                    if (!loadSpan(window_end)) {
+                        return false;
+                    }
+                }
+                input = context.read_buffer.data() + (data_offset - span_begin);
+            }
+            inputs[window_end - window_begin] = input;
+            input_sizes[window_end - window_begin] = static_cast<size_t>(data_length);
+            copies[window_end - window_begin] = copy;
+            window_bytes += data_length;
+            ++window_end;
+        }
 
-        switch (operation.type()) {
-        case chromeos_update_engine::InstallOperation_Type_REPLACE: {
-            decompressed_data = compressed_data;
-            // Update hash with all data
-            if (verify_hash_) {
-                hasher.update(compressed_data.data(), compressed_data.size());
+        // Slots of the window whose digest was computed up front
+        int hashed_slots[MULTI_HASH_MAX_LANES];
+        const uint8_t* hash_inputs[MULTI_HASH_MAX_LANES];
+        size_t hash_sizes[MULTI_HASH_MAX_LANES];
+        uint8_t digests[MULTI_HASH_MAX_LANES][SHA256_DIGEST_SIZE];
+        const uint8_t* digest_of[WINDOW_MAX_OPS] = {};
+        size_t hash_count = 0;
+        for (int op_index = window_begin; op_index < window_end && hash_count < lanes; ++op_index) {
+            if (multiHashable(op_index)) {
+                const int slot = op_index - window_begin;
+                hashed_slots[hash_count] = slot;
+                hash_inputs[hash_count] = inputs[slot];
+                hash_sizes[hash_count] = input_sizes[slot];
+                hash_count++;
+            }
+        }
+        if (hash_count > 1) {
+            SHA256Hasher::hashMany(hash_inputs, hash_sizes, hash_count, digests);
+            for (size_t i = 0; i < hash_count; ++i) {
+                digest_of[hashed_slots[i]] = digests[i];
             }
-            break;
         }
 
-        case chromeos_update_engine::InstallOperation_Type_REPLACE_XZ: {
-            decompressed_data.resize(expected_size);
-            lzma_stream strm = LZMA_STREAM_INIT;
-            lzma_ret ret = lzma_stream_decoder(&strm, UINT64_MAX, 0);
-            if (ret != LZMA_OK) {
-                std::cerr << "\nXZ decoder init failed for " << name << "\n";
+        for (int op_index = window_begin; op_index < window_end; ++op_index) {
+            if (job.failed) {
+                // Another batch of this partition already failed
+                return false;
+            }
+
+            const auto& operation = partition.operations(op_index);
+            if (operation.dst_extents_size() == 0) {
+                std::cerr << "\nInvalid operation for " << name << "\n";
                 return false;
             }
+            const int slot = op_index - window_begin;
+
+            if (copies[slot]) {
+                const int64_t data_offset = data_offset_ + operation.data_offset();
+                const uint8_t* output_data = nullptr;
+                size_t output_size = 0;
+                bool copied = false;
+                // A mapped blob is hashed before the kernel copies it
+                if (inputs[slot] && !decodeOperation(operation,
+                                                     name,
+                                                     inputs[slot],
+                                                     input_sizes[slot],
+                                                     digest_of[slot],
+                                                     context.decoders,
+                                                     context.outputs[slot],
+                                                     &output_data,
+                                                     &output_size)) {
+                    return false;
+                }
+                if (!job.copy(operation, file_, data_offset, inputs[slot], &copied)) {
+                    return false;
+                }
+                if (copied) {
+                    continue;
+                }
 
-            strm.next_in = compressed_data.data();
-            strm.avail_in = compressed_data.size();
-            strm.next_out = decompressed_data.data();
-            strm.avail_out = decompressed_data.size();
+                // The kernel refused: write the blob from memory after all
+                if (inputs[slot]) {
+                    if (!job.store(operation, output_data, output_size, sparse_, batch)) {
+                        return false;
+                    }
+                    continue;
+                }
+                // An earlier fallback of this window may still be in the batch
+                if (!batch.flush()) {
+                    return false;
+                }
+                const int64_t data_length = operation.data_length();
+                inputs[slot] = context.copy_fallback.resize(data_length);
+                if (readBytes(context.copy_fallback.data(), data_offset, data_length) !=
+                    data_length) {
+                    std::cerr << "\nFailed to read data for " << name << "\n";
+                    return false;
+                }
+                job.read_calls++;
+                job.blobs_read++;
+            }
 
-            // Hash the compressed data (input)
-            if (verify_hash_) {
-                hasher.update(compressed_data.data(), compressed_data.size());
+            const uint8_t* output_data = nullptr;
+            size_t output_size = 0;
+            if (!decodeOperation(operation,
+                                 name,
+                                 inputs[slot],
+                                 input_sizes[slot],
+                                 digest_of[slot],
+                                 context.decoders,
+                                 context.outputs[slot],
+                                 &output_data,
+                                 &output_size)) {
+                return false;
             }
 
-            ret = lzma_code(&strm, LZMA_FINISH);
-            lzma_end(&strm);
-            if (ret != LZMA_STREAM_END) {
-                std::cerr << "\nXZ decompression failed for " << name << "\n";
+            if (!job.store(operation, output_data, output_size, sparse_, batch)) {
                 return false;
             }
+        }
+
+        // The next window reuses the buffers the batch points into
+        if (!batch.flush()) {
+            return false;
+        }
+        reportProgress(job, window_end - window_begin, progress_tracker);
+        window_begin = window_end;
+    }
+
+    return true;
+}
+
+#ifdef __linux__
+bool Payload::extractOperationsIoUring(PartitionJob& job,
+                                       int begin,
+                                       int end,
+                                       ProgressTracker* progress_tracker,
+                                       WorkerContext& context)
+{
+    IoRing& ring = *context.ring;
+    const auto& partition = *job.partition;
+    const std::string& name = job.name;
+
+    // Each slot carries one operation from its read to its write, so there is
+    // never more than one request per slot and the ring can not overflow.
+    // Slot buffers belong to the thread and are reused by every batch.
+    struct Slot {
+        int op_index;
+        bool read_done;
+        ScratchBuffer* input;
+        ScratchBuffer* output;
+        const uint8_t* write_data;
+        size_t write_size;
+        int64_t write_offset;
+    };
+    context.slot_buffers.resize(2 * ring.capacity());
+    std::vector<Slot> slots(ring.capacity());
+    for (size_t i = 0; i < slots.size(); ++i) {
+        slots[i].input = &context.slot_buffers[2 * i];
+        slots[i].output = &context.slot_buffers[2 * i + 1];
+    }
+    std::vector<int> free_slots;
+    for (int i = static_cast<int>(slots.size()) - 1; i >= 0; --i) {
+        free_slots.push_back(i);
+    }
+    std::queue<int> decode_order;
+
+    const int in_fd = file_.fd();
+    const int out_fd = job.output.fd();
+    int next_read = begin;
+    int completed_ops = begin;
+    bool ok = true;
+
+    auto isWrite = [](uint64_t user_data) { return (user_data & 1) != 0; };
+    auto hasZeroBlock = [](const uint8_t* data, size_t size) {
+        for (size_t pos = 0; pos < size; pos += BLOCK_SIZE) {
+            if (isAllZero(data + pos, std::min<size_t>(BLOCK_SIZE, size - pos))) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto slotOf = [](uint64_t user_data) { return static_cast<int>(user_data >> 1); };
+    // Short writes are finished synchronously
+    auto finishWrite = [&](const Slot& slot, int32_t result) {
+        if (result < 0 || !job.output.addWritten(result) ||
+            !job.output.writeAt(slot.write_data + result,
+                                              slot.write_size - result,
+                                              slot.write_offset + result)) {
+            std::cerr << "\nFailed to write output for " << name << "\n";
+            return false;
+        }
+        job.write_calls++;
+        job.extents_written++;
+        return job.written(slot.write_offset, slot.write_data, slot.write_size);
+    };
+
+    while (ok && completed_ops < end) {
+        if (job.failed) {
+            // Another batch of this partition already failed
+            ok = false;
             break;
         }
 
-        case chromeos_update_engine::InstallOperation_Type_REPLACE_BZ: {
-            decompressed_data.resize(expected_size);
-            unsigned int dest_len = expected_size;
-            
-            // Hash the compressed data (input)
-            if (verify_hash_) {
-                hasher.update(compressed_data.data(), compressed_data.size());
+        // Keep as many blob reads in flight as there are free slots
+        while (next_read < end && !free_slots.empty()) {
+            const auto& operation = partition.operations(next_read);
+            if (operation.dst_extents_size() == 0) {
+                std::cerr << "\nInvalid operation for " << name << "\n";
+                ok = false;
+                break;
             }
 
-            int ret = BZ2_bzBuffToBuffDecompress(reinterpret_cast<char*>(decompressed_data.data()),
-                                                 &dest_len,
-                                                 reinterpret_cast<char*>(compressed_data.data()),
-                                                 compressed_data.size(),
-                                                 0,
-                                                 0);
-            if (ret != BZ_OK) {
-                std::cerr << "\nBZ2 decompression failed for " << name << "\n";
-                return false;
+            int slot_index = free_slots.back();
+            Slot& slot = slots[slot_index];
+            slot.op_index = next_read;
+            slot.read_done = operation.data_length() == 0;
+            slot.input->resize(operation.data_length());
+            if (!slot.read_done &&
+                !ring.queueRead(in_fd,
+                                slot.input->data(),
+                                static_cast<uint32_t>(operation.data_length()),
+                                data_offset_ + operation.data_offset(),
+                                static_cast<uint64_t>(slot_index) << 1)) {
+                break;
             }
+            if (!slot.read_done) {
+                job.read_calls++;
+                job.blobs_read++;
+            }
+            free_slots.pop_back();
+            decode_order.push(slot_index);
+            next_read++;
+        }
+        if (!ok || !ring.submit()) {
+            ok = false;
             break;
         }
 
-        case chromeos_update_engine::InstallOperation_Type_ZSTD: {
-            size_t dest_size =
-                ZSTD_getFrameContentSize(compressed_data.data(), compressed_data.size());
-            decompressed_data.resize(dest_size);
-            
-            // Hash the compressed data (input)
-            if (verify_hash_) {
-                hasher.update(compressed_data.data(), compressed_data.size());
+        // Operations are decoded in order; the write is queued and left in flight
+        if (!decode_order.empty() && slots[decode_order.front()].read_done) {
+            int slot_index = decode_order.front();
+            decode_order.pop();
+            Slot& slot = slots[slot_index];
+            const auto& operation = partition.operations(slot.op_index);
+
+            if (!decodeOperation(operation,
+                                 name,
+                                 slot.input->data(),
+                                 slot.input->size(),
+                                 nullptr,
+                                 context.decoders,
+                                 *slot.output,
+                                 &slot.write_data,
+                                 &slot.write_size)) {
+                ok = false;
+                break;
             }
 
-            size_t ret = ZSTD_decompress(decompressed_data.data(),
-                                         decompressed_data.size(),
-                                         compressed_data.data(),
-                                         compressed_data.size());
-            if (ZSTD_isError(ret)) {
-                std::cerr << "\nZSTD decompression failed for " << name << "\n";
-                return false;
+            slot.write_offset = operation.dst_extents(0).start_block() * BLOCK_SIZE;
+            if (!slot.write_data || operation.dst_extents_size() > 1 ||
+                (sparse_ && hasZeroBlock(slot.write_data, slot.write_size))) {
+                // Zero ranges are a single fallocate, not worth a ring entry, and
+                // scattered or sparse writes take several requests: do them now
+                WriteBatch batch;
+                if (!job.store(operation, slot.write_data, slot.write_size, sparse_, batch) ||
+                    !batch.flush()) {
+                    ok = false;
+                    break;
+                }
+                free_slots.push_back(slot_index);
+            } else {
+                if (operation.type() == chromeos_update_engine::InstallOperation_Type_REPLACE) {
+                    job.replace_buffered_bytes += slot.write_size;
+                }
+                if (slot.write_size > UINT32_MAX ||
+                    !ring.queueWrite(out_fd,
+                                     slot.write_data,
+                                     static_cast<uint32_t>(slot.write_size),
+                                     slot.write_offset,
+                                     (static_cast<uint64_t>(slot_index) << 1) | 1)) {
+                    // No room in the ring (or too large for one request): write it now
+                    if (!finishWrite(slot, 0)) {
+                        ok = false;
+                        break;
+                    }
+                    free_slots.push_back(slot_index);
+                } else {
+                    job.ring_writes++;
+                }
             }
-            break;
+
+            completed_ops++;
+            reportProgress(job, 1, progress_tracker);
+            continue;
         }
 
-        case chromeos_update_engine::InstallOperation_Type_ZERO: {
-            decompressed_data.resize(expected_size, 0);
-            // No data to hash for ZERO operations
+        IoRing::Completion completion;
+        if (!ring.wait(completion)) {
+            ok = false;
             break;
         }
 
-        default:
-            std::cerr << "\nUnhandled operation type for " << name << "\n";
-            return false;
+        int slot_index = slotOf(completion.user_data);
+        Slot& slot = slots[slot_index];
+        if (isWrite(completion.user_data)) {
+            if (!finishWrite(slot, completion.result)) {
+                ok = false;
+                break;
+            }
+            free_slots.push_back(slot_index);
+        } else {
+            const auto& operation = partition.operations(slot.op_index);
+            int64_t got = completion.result;
+            int64_t length = static_cast<int64_t>(slot.input->size());
+            if (got >= 0 && got < length) {
+                int64_t rest = file_.readAt(slot.input->data() + got,
+                                            data_offset_ + operation.data_offset() + got,
+                                            length - got);
+                got = rest < 0 ? rest : got + rest;
+            }
+            if (got != length) {
+                std::cerr << "\nFailed to read data for " << name << "\n";
+                ok = false;
+                break;
+            }
+            slot.read_done = true;
         }
+    }
 
-        if (decompressed_data.size() != static_cast<size_t>(expected_size)) {
-            std::cerr << "\nSize mismatch for " << name << "\n";
-            return false;
+    // The kernel may still reference slot buffers; drain before they go away
+    IoRing::Completion completion;
+    while (ring.inFlight() > 0 && ring.wait(completion)) {
+        if (ok && isWrite(completion.user_data)) {
+            ok = finishWrite(slots[slotOf(completion.user_data)], completion.result);
         }
+    }
 
-        // Verify SHA-256 hash if enabled and hash is present
-        if (verify_hash_ && operation.has_data_sha256_hash() && 
-            !operation.data_sha256_hash().empty()) {
-            
-            uint8_t calculated_hash[SHA256_DIGEST_SIZE];
-            hasher.finalize(calculated_hash);
+    return ok;
+}
+#endif
 
-            const std::string& expected_hash_bytes = operation.data_sha256_hash();
-            
-            if (expected_hash_bytes.size() == SHA256_DIGEST_SIZE) {
-                if (memcmp(calculated_hash, expected_hash_bytes.data(), SHA256_DIGEST_SIZE) != 0) {
-                    // Convert hashes to hex for error message
-                    char calculated_hex[65];
-                    sha256_to_hex(calculated_hash, calculated_hex);
-                    
-                    char expected_hex[65];
-                    sha256_to_hex(reinterpret_cast<const uint8_t*>(expected_hash_bytes.data()), 
-                                  expected_hex);
-                    
-                    std::cerr << "\n✗ Hash verification failed for " << name << "\n";
-                    std::cerr << "  Expected: " << expected_hex << "\n";
-                    std::cerr << "  Got:      " << calculated_hex << "\n";
-                    return false;
+bool Payload::extractPipelined(const std::vector<std::unique_ptr<PartitionJob>>& jobs,
+                               ProgressTracker* progress_tracker)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int readers = std::max(pipeline_.readers, 1);
+    const int workers = std::max(pipeline_.workers, 1);
+    const int writers = std::max(pipeline_.writers, 1);
+    const size_t depth =
+        pipeline_.queue_depth > 0 ? static_cast<size_t>(pipeline_.queue_depth) : 2 * workers;
+
+    // One operation travelling through the stages. Items are recycled, so the
+    // buffers keep their capacity and the item count bounds memory use.
+    struct Item {
+        PartitionJob* job;
+        int op_index;
+        const uint8_t* input;
+        ScratchBuffer input_buffer;
+        ScratchBuffer output_buffer;
+        const uint8_t* write_data;
+        size_t write_size;
+    };
+
+    // Time each stage spent working, starved of input and blocked on output
+    struct StageStats {
+        const char* name;
+        int threads;
+        std::atomic<uint64_t> busy_ns{0};
+        std::atomic<uint64_t> wait_in_ns{0};
+        std::atomic<uint64_t> wait_out_ns{0};
+    };
+
+    std::vector<std::pair<PartitionJob*, int>> operations;
+    for (const auto& job : jobs) {
+        for (int i = 0; i < job->partition->operations_size(); ++i) {
+            operations.emplace_back(job.get(), i);
+        }
+    }
+    if (order_ == ExtractOrder::Input) {
+        std::stable_sort(operations.begin(),
+                         operations.end(),
+                         [](const std::pair<PartitionJob*, int>& a,
+                            const std::pair<PartitionJob*, int>& b) {
+                             return inputOffset(*a.first->partition, a.second, a.second + 1) <
+                                    inputOffset(*b.first->partition, b.second, b.second + 1);
+                         });
+    }
+
+    const size_t item_count = 2 * depth + readers + workers + writers;
+    std::vector<Item> items(item_count);
+    BoundedQueue<Item*> free_items(item_count);
+    BoundedQueue<Item*> decode_queue(depth);
+    BoundedQueue<Item*> write_queue(depth);
+    for (auto& item : items) {
+        free_items.push(&item);
+    }
+
+    StageStats read_stats{"read", readers};
+    StageStats decode_stats{"decode", workers};
+    StageStats write_stats{"write", writers};
+    std::atomic<size_t> next_op{0};
+    std::atomic<int> active_readers{readers};
+    std::atomic<int> active_workers{workers};
+    std::atomic<bool> error_occurred{false};
+    const bool mapped = file_.data() != nullptr;
+
+    auto elapsed = [](Clock::time_point since) {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count());
+    };
+    auto fail = [&](Item* item) {
+        failJob(*item->job);
+        error_occurred = true;
+        free_items.push(item);
+    };
+
+    auto reader = [&]() {
+        auto start = Clock::now();
+        uint64_t waited = 0;
+        for (size_t i = next_op++; i < operations.size(); i = next_op++) {
+            PartitionJob* job = operations[i].first;
+            if (job->failed) {
+                continue;
+            }
+
+            Item* item = nullptr;
+            auto wait_start = Clock::now();
+            free_items.pop(item);
+            waited += elapsed(wait_start);
+
+            item->job = job;
+            item->op_index = operations[i].second;
+            const auto& operation = job->partition->operations(item->op_index);
+            int64_t data_offset = data_offset_ + operation.data_offset();
+            int64_t data_length = operation.data_length();
+
+            if (mapped) {
+                item->input = mappedBytes(data_offset, data_length);
+                if (!item->input) {
+                    std::cerr << "\nData for " << job->name << " lies outside the payload\n";
+                    fail(item);
+                    continue;
+                }
+            } else {
+                uint8_t* buffer = item->input_buffer.resize(data_length);
+                if (readBytes(buffer, data_offset, data_length) != data_length) {
+                    std::cerr << "\nFailed to read data for " << job->name << "\n";
+                    fail(item);
+                    continue;
+                }
+                item->input = buffer;
+                if (data_length > 0) {
+                    job->read_calls++;
+                    job->blobs_read++;
                 }
             }
+
+            wait_start = Clock::now();
+            decode_queue.push(item);
+            waited += elapsed(wait_start);
+        }
+
+        read_stats.wait_out_ns += waited;
+        read_stats.busy_ns += elapsed(start) - waited;
+        if (--active_readers == 0) {
+            decode_queue.close();
         }
+    };
+
+    auto worker = [&]() {
+        DecoderCache decoders;
+        auto start = Clock::now();
+        uint64_t waited_in = 0;
+        uint64_t waited_out = 0;
+        while (true) {
+            Item* item = nullptr;
+            auto wait_start = Clock::now();
+            bool got = decode_queue.pop(item);
+            waited_in += elapsed(wait_start);
+            if (!got) {
+                break;
+            }
 
-        output.write(reinterpret_cast<char*>(decompressed_data.data()), decompressed_data.size());
+            PartitionJob* job = item->job;
+            const auto& operation = job->partition->operations(item->op_index);
+            if (job->failed) {
+                free_items.push(item);
+                continue;
+            }
+            if (operation.dst_extents_size() == 0) {
+                std::cerr << "\nInvalid operation for " << job->name << "\n";
+                fail(item);
+                continue;
+            }
+            if (!decodeOperation(operation,
+                                 job->name,
+                                 item->input,
+                                 static_cast<size_t>(operation.data_length()),
+                                 nullptr,
+                                 decoders,
+                                 item->output_buffer,
+                                 &item->write_data,
+                                 &item->write_size)) {
+                fail(item);
+                continue;
+            }
 
-        completed_ops++;
+            wait_start = Clock::now();
+            write_queue.push(item);
+            waited_out += elapsed(wait_start);
+        }
 
-        if (progress_tracker &&
-            (completed_ops == total_ops || (completed_ops % (total_ops / 20 + 1)) == 0)) {
-            progress_tracker->update(name, completed_ops, total_ops);
+        decode_stats.wait_in_ns += waited_in;
+        decode_stats.wait_out_ns += waited_out;
+        decode_stats.busy_ns += elapsed(start) - waited_in - waited_out;
+        if (--active_workers == 0) {
+            write_queue.close();
         }
-    }
+    };
+
+    auto writer = [&]() {
+        auto start = Clock::now();
+        uint64_t waited = 0;
+        // Items whose buffers the batch may still point into
+        WriteBatch batch;
+        std::vector<Item*> held;
+        auto release = [&](bool ok) {
+            ok = batch.flush() && ok;
+            for (Item* held_item : held) {
+                if (ok) {
+                    reportProgress(*held_item->job, 1, progress_tracker);
+                } else {
+                    failJob(*held_item->job);
+                    error_occurred = true;
+                }
+                free_items.push(held_item);
+            }
+            held.clear();
+        };
+
+        while (true) {
+            // Keep merging while writes are already queued; flush before waiting
+            Item* item = nullptr;
+            if (!write_queue.tryPop(item)) {
+                release(true);
+                auto wait_start = Clock::now();
+                bool got = write_queue.pop(item);
+                waited += elapsed(wait_start);
+                if (!got) {
+                    break;
+                }
+            }
+
+            PartitionJob* job = item->job;
+            if (job->failed) {
+                free_items.push(item);
+                continue;
+            }
+            held.push_back(item);
+            const auto& operation = job->partition->operations(item->op_index);
+            if (!job->store(operation, item->write_data, item->write_size, sparse_, batch)) {
+                release(false);
+            } else if (held.size() >= static_cast<size_t>(WINDOW_MAX_OPS)) {
+                release(true);
+            }
+        }
+
+        write_stats.wait_in_ns += waited;
+        write_stats.busy_ns += elapsed(start) - waited;
+    };
 
-    if (progress_tracker) {
-        progress_tracker->update(name, total_ops, total_ops);
+    auto wall_start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; ++i) {
+        threads.emplace_back(reader);
+    }
+    for (int i = 0; i < workers; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (int i = 0; i < writers; ++i) {
+        threads.emplace_back(writer);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    double wall_ns = static_cast<double>(elapsed(wall_start));
+
+    if (show_stats_ && wall_ns > 0) {
+        std::cout << "Pipeline stages (share of thread time):\n";
+        for (const StageStats* stage : {&read_stats, &decode_stats, &write_stats}) {
+            double total = wall_ns * stage->threads;
+            std::cout << "  " << std::left << std::setw(7) << stage->name << std::right
+                      << std::setw(3) << stage->threads << " thread(s)  " << std::fixed
+                      << std::setprecision(1) << std::setw(5) << 100.0 * stage->busy_ns / total
+                      << "% busy  " << std::setw(5) << 100.0 * stage->wait_in_ns / total
+                      << "% starved  " << std::setw(5) << 100.0 * stage->wait_out_ns / total
+                      << "% blocked\n";
+        }
+        std::cout << "  queue occupancy: decode " << std::setprecision(1)
+                  << decode_queue.averageOccupancy() << "/" << decode_queue.capacity()
+                  << ", write " << write_queue.averageOccupancy() << "/"
+                  << write_queue.capacity() << "\n";
     }
 
-    return true;
+    return !error_occurred;
 }
 
 bool Payload::extractAll(const std::string& target_dir, int concurrency)
@@ -559,6 +1829,31 @@ bool Payload::extractSelected(const std::string& target_dir,
         return false;
     }
 
+    // A stream is read once, front to back: a single pipeline reader walks
+    // every selected operation in payload order and skips over the rest,
+    // while decoding and writing still fan out over several threads
+    if (is_stream_) {
+        order_ = ExtractOrder::Input;
+        if (pipeline_.readers > 1) {
+            std::cerr << "Note: a stream has a single reader, ignoring the other "
+                      << pipeline_.readers - 1 << "\n";
+        }
+        pipeline_.readers = 1;
+        if (pipeline_.workers <= 0) {
+            pipeline_.workers = concurrency;
+        }
+        if (pipeline_.writers <= 0) {
+            pipeline_.writers = 1;
+        }
+    }
+
+    // Remote blobs are fetched ahead front to back, so the operations are
+    // consumed in the same order and each request is freed soon after it lands
+    const bool prefetch = is_http_ && prefetch_budget_ > 0;
+    if (prefetch) {
+        order_ = ExtractOrder::Input;
+    }
+
     std::cout << "\nExtracting " << to_extract.size() << " partition(s)...\n";
 
     // Initialize progress tracker
@@ -573,47 +1868,379 @@ bool Payload::extractSelected(const std::string& target_dir,
     
     progress_tracker.init(partition_names, operation_counts);
 
-    std::queue<const chromeos_update_engine::PartitionUpdate*> work_queue;
-    for (auto* p : to_extract) {
-        work_queue.push(p);
+    // Largest partitions first, so the long-running work starts right away
+    if (order_ == ExtractOrder::Partition) {
+        std::stable_sort(to_extract.begin(),
+                         to_extract.end(),
+                         [](const chromeos_update_engine::PartitionUpdate* a,
+                            const chromeos_update_engine::PartitionUpdate* b) {
+                             return a->new_partition_info().size() > b->new_partition_info().size();
+                         });
     }
 
-    std::mutex queue_mutex;
+    std::vector<std::unique_ptr<PartitionJob>> jobs;
+    std::vector<WorkStealingPool::Task> tasks;
+    // Batches keyed by where their data starts, for ExtractOrder::Input
+    std::vector<std::pair<uint64_t, WorkStealingPool::Task>> input_tasks;
     std::atomic<bool> error_occurred{false};
+    int images_preallocated = 0;
+    int images_unchecked = 0;
+
+    // One context per pool thread; a thread without a ring uses sync I/O
+    std::vector<WorkerContext> contexts(concurrency);
+    for (auto& context : contexts) {
+        if (io_engine_ == IoEngine::IoUring) {
+            context.ring = std::make_unique<IoRing>();
+            if (!context.ring->init(IO_RING_DEPTH)) {
+                context.ring.reset();
+            }
+        }
+    }
 
-    auto worker = [&]() {
-        while (true) {
-            const chromeos_update_engine::PartitionUpdate* partition = nullptr;
-            {
-                std::lock_guard<std::mutex> lock(queue_mutex);
-                if (work_queue.empty())
-                    break;
-                partition = work_queue.front();
-                work_queue.pop();
+    auto runBatch = [&](PartitionJob* job, int begin, int end, int thread_index) {
+        if (job->failed) {
+            return;
+        }
+
+        bool ok;
+#ifdef __linux__
+        if (contexts[thread_index].ring) {
+            ok = extractOperationsIoUring(
+                *job, begin, end, &progress_tracker, contexts[thread_index]);
+        } else
+#endif
+        {
+            ok = extractOperations(*job, begin, end, &progress_tracker, contexts[thread_index]);
+        }
+
+        if (!ok) {
+            failJob(*job);
+            error_occurred = true;
+        }
+    };
+
+    for (const auto* p : to_extract) {
+        auto job = std::make_unique<PartitionJob>();
+        job->partition = p;
+        job->name = p->partition_name();
+
+        std::string output_path = target_dir + "/" + job->name + ".img";
+        if (!job->output.open(output_path)) {
+            std::cerr << "Failed to create output file: " << output_path << "\n";
+            error_occurred = true;
+            continue;
+        }
+        // A sparse image should only take the space its data needs
+        if (preallocate_ && !sparse_ && job->output.preallocate(p->new_partition_info().size())) {
+            images_preallocated++;
+        }
+        if (sync_mode_ == SyncMode::Periodic) {
+            job->output.setSyncInterval(SYNC_INTERVAL_BYTES);
+        }
+        if (verify_hash_ && p->new_partition_info().hash().size() == SHA256_DIGEST_SIZE) {
+            // The hash covers the verity hash tree and FEC data, which the
+            // device computes after applying the update and the payload lacks
+            if (p->has_hash_tree_extent() || p->has_fec_extent()) {
+                images_unchecked++;
+            } else {
+                job->hasher = std::make_unique<PartitionHasher>(
+                    job->output, p->new_partition_info().size(), HASH_HOLD_BYTES);
             }
+        }
 
-            std::string output_path = target_dir + "/" + partition->partition_name() + ".img";
-            if (!extractPartition(*partition, output_path, &progress_tracker)) {
-                error_occurred = true;
+        // The pipeline streams single operations through its stages instead
+        if (pipeline_.enabled()) {
+            jobs.push_back(std::move(job));
+            continue;
+        }
+
+        // Large partitions are cut into batches of operations so that several
+        // threads can work on disjoint extents of the same image
+        PartitionJob* job_ptr = job.get();
+        int begin = 0;
+        uint64_t batch_bytes = 0;
+        for (int i = 0; i < p->operations_size(); ++i) {
+            for (const auto& extent : p->operations(i).dst_extents()) {
+                batch_bytes += extent.num_blocks() * BLOCK_SIZE;
+            }
+            if (batch_bytes >= OPERATION_BATCH_BYTES || i + 1 == p->operations_size()) {
+                int end = i + 1;
+                auto task = [&runBatch, job_ptr, begin, end](int thread_index) {
+                    runBatch(job_ptr, begin, end, thread_index);
+                };
+                if (order_ == ExtractOrder::Input) {
+                    input_tasks.emplace_back(inputOffset(*p, begin, end), task);
+                } else {
+                    tasks.push_back(task);
+                }
+                begin = end;
+                batch_bytes = 0;
             }
         }
-    };
 
-    std::vector<std::thread> threads;
-    for (int i = 0; i < concurrency; ++i) {
-        threads.emplace_back(worker);
+        jobs.push_back(std::move(job));
     }
 
-    for (auto& t : threads) {
-        t.join();
+    // The pool deals tasks round-robin and every thread takes its own from the
+    // front, so batches sorted by offset keep the threads reading one region
+    // of the payload together and moving through it front to back
+    if (order_ == ExtractOrder::Input) {
+        std::stable_sort(input_tasks.begin(),
+                         input_tasks.end(),
+                         [](const std::pair<uint64_t, WorkStealingPool::Task>& a,
+                            const std::pair<uint64_t, WorkStealingPool::Task>& b) {
+                             return a.first < b.first;
+                         });
+        for (auto& entry : input_tasks) {
+            tasks.push_back(std::move(entry.second));
+        }
+    }
+
+    if (prefetch) {
+        std::vector<RangePrefetcher::Range> ranges;
+        for (const auto& job : jobs) {
+            for (const auto& operation : job->partition->operations()) {
+                if (operation.data_length() > 0) {
+                    ranges.push_back({data_offset_ + static_cast<int64_t>(operation.data_offset()),
+                                      static_cast<int64_t>(operation.data_length())});
+                }
+            }
+        }
+        RangePrefetcher::Config config;
+        config.max_gap = PREFETCH_MAX_GAP;
+        config.max_request = PREFETCH_MAX_REQUEST;
+        config.budget = prefetch_budget_;
+        config.threads = PREFETCH_THREADS;
+        prefetcher_ = std::make_unique<RangePrefetcher>(
+            [this](void* buffer, int64_t offset, int64_t length) {
+                return readSource(buffer, offset, length);
+            },
+            std::move(ranges),
+            config);
+        std::cout << "Prefetching " << prefetcher_->requestCount() << " request(s), "
+                  << formatBytes(prefetch_budget_) << " ahead at most\n";
+        prefetcher_->start();
+    }
+
+    auto run_start = std::chrono::steady_clock::now();
+    WorkStealingPool pool(concurrency);
+    if (pipeline_.enabled()) {
+        if (!extractPipelined(jobs, &progress_tracker)) {
+            error_occurred = true;
+        }
+    } else {
+        pool.run(std::move(tasks));
     }
 
+    RangePrefetcher::Stats prefetch_stats{};
+    if (prefetcher_) {
+        prefetch_stats = prefetcher_->stats();
+        prefetcher_.reset();
+    }
+
+    int images_verified = 0;
+    uint64_t read_back = 0;
+    uint64_t image_bytes = 0;
+    int64_t extents = 0;
+    int images_mapped = 0;
+    uint64_t output_syscalls = 0;
+    uint64_t output_syncs = 0;
+    for (auto& job : jobs) {
+        // Trailing zero ranges are never written, so size the image explicitly
+        if (!job->failed && !job->output.extendTo(job->partition->new_partition_info().size())) {
+            std::cerr << "\nFailed to size output file for " << job->name << "\n";
+            job->failed = true;
+            error_occurred = true;
+        }
+        if (!job->failed && sync_mode_ != SyncMode::None && !job->output.sync()) {
+            std::cerr << "\nFailed to sync output file for " << job->name << "\n";
+            job->failed = true;
+            error_occurred = true;
+        }
+
+        if (job->hasher && !job->failed) {
+            uint8_t calculated_hash[SHA256_DIGEST_SIZE];
+            const std::string& expected_hash = job->partition->new_partition_info().hash();
+            if (!job->hasher->finish(calculated_hash)) {
+                std::cerr << "\nFailed to read back output of " << job->name << " for hashing\n";
+                error_occurred = true;
+            } else if (memcmp(calculated_hash, expected_hash.data(), SHA256_DIGEST_SIZE) != 0) {
+                char calculated_hex[65];
+                sha256_to_hex(calculated_hash, calculated_hex);
+                char expected_hex[65];
+                sha256_to_hex(reinterpret_cast<const uint8_t*>(expected_hash.data()),
+                              expected_hex);
+
+                std::cerr << "\n✗ Image hash verification failed for " << job->name << "\n";
+                std::cerr << "  Expected: " << expected_hex << "\n";
+                std::cerr << "  Got:      " << calculated_hex << "\n";
+                error_occurred = true;
+            } else {
+                images_verified++;
+            }
+            read_back += job->hasher->readBackBytes();
+        }
+
+        if (show_stats_) {
+            image_bytes += job->partition->new_partition_info().size();
+            output_syscalls += job->output.syscallCount();
+            output_syncs += job->output.syncCount();
+            int64_t count = job->output.extentCount();
+            if (count >= 0) {
+                extents += count;
+                images_mapped++;
+            }
+        }
+
+        if (!job->output.close()) {
+            std::cerr << "Failed to finish output file for " << job->name << "\n";
+            error_occurred = true;
+        }
+    }
+
+    double run_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
     progress_tracker.finalize();
 
+    if (sparse_) {
+        uint64_t hole_bytes = 0;
+        uint64_t zero_block_bytes = 0;
+        for (const auto& job : jobs) {
+            hole_bytes += job->hole_bytes;
+            zero_block_bytes += job->zero_block_bytes;
+        }
+        std::cout << "Sparse output: " << formatBytes(hole_bytes + zero_block_bytes)
+                  << " left unwritten (" << formatBytes(hole_bytes) << " ZERO/DISCARD, "
+                  << formatBytes(zero_block_bytes) << " zero blocks in data)\n";
+    }
+
+    if (io_engine_ == IoEngine::IoUring) {
+        uint64_t samples = 0;
+        uint64_t total = 0;
+        unsigned max_depth = 0;
+        for (const auto& context : contexts) {
+            if (context.ring) {
+                samples += context.ring->depthSamples();
+                total += context.ring->depthTotal();
+                max_depth = std::max(max_depth, context.ring->depthMax());
+            }
+        }
+        if (samples > 0) {
+            std::cout << "io_uring queue depth: " << std::fixed << std::setprecision(1)
+                      << static_cast<double>(total) / samples << " average, " << max_depth
+                      << " max (" << IO_RING_DEPTH << " per thread)\n";
+        }
+    }
+
+    if (show_stats_ && !pipeline_.enabled()) {
+        const auto& stats = pool.stats();
+        std::cout << "Scheduler: " << stats.tasks << " batches on " << pool.size()
+                  << " thread(s), " << stats.steals << " stolen, tail idle " << std::fixed
+                  << std::setprecision(1) << stats.tail_idle_ms << " ms of "
+                  << stats.wall_ms * pool.size() << " ms\n";
+    }
+
+    if (show_stats_) {
+        uint64_t total_ops = 0;
+        for (const auto& job : jobs) {
+            total_ops += job->partition->operations_size();
+        }
+        uint64_t allocations = ScratchBuffer::allocationCount();
+        std::cout << "Buffers: " << allocations << " allocation(s) for " << total_ops
+                  << " operation(s) (" << std::setprecision(3)
+                  << (total_ops ? static_cast<double>(allocations) / total_ops : 0.0)
+                  << " per operation), " << formatBytes(ScratchBuffer::allocatedBytes())
+                  << " allocated\n";
+        std::cout << "Decoders: " << DecoderCache::setupCount()
+                  << " state allocation(s) across all threads\n";
+        if (verify_hash_) {
+            std::cout << "SHA-256: " << sha256_implementation();
+            if (SHA256Hasher::lanes() > 1) {
+                std::cout << ", " << SHA256Hasher::lanes() << "-lane batches for small blobs";
+            }
+            std::cout << "\n";
+            std::cout << "Image hashes: " << images_verified << " verified, " << images_unchecked
+                      << " not checked (verity data is built on the device), "
+                      << formatBytes(read_back) << " read back from output\n";
+        }
+        uint64_t extents_written = 0;
+        uint64_t write_calls = 0;
+        for (const auto& job : jobs) {
+            extents_written += job->extents_written;
+            write_calls += job->write_calls;
+        }
+        std::cout << "Writes: " << extents_written << " extent(s) in " << write_calls
+                  << " write call(s)\n";
+        if (!file_.data()) {
+            uint64_t blobs_read = 0;
+            uint64_t read_calls = 0;
+            for (const auto& job : jobs) {
+                blobs_read += job->blobs_read;
+                read_calls += job->read_calls;
+            }
+            std::cout << "Reads: " << blobs_read << " operation blob(s) in " << read_calls
+                      << " read call(s)\n";
+        }
+        uint64_t cloned_bytes = 0;
+        uint64_t kernel_copied_bytes = 0;
+        uint64_t replace_buffered_bytes = 0;
+        uint64_t ring_writes = 0;
+        for (const auto& job : jobs) {
+            ring_writes += job->ring_writes;
+            cloned_bytes += job->cloned_bytes;
+            kernel_copied_bytes += job->kernel_copied_bytes;
+            replace_buffered_bytes += job->replace_buffered_bytes;
+        }
+        std::cout << "Output syscalls: " << output_syscalls << " (" << output_syncs << " sync)";
+        if (ring_writes > 0) {
+            std::cout << ", plus " << ring_writes << " write(s) submitted through io_uring";
+        }
+        std::cout << "\n";
+        std::cout << "REPLACE data: " << formatBytes(cloned_bytes) << " reflinked, "
+                  << formatBytes(kernel_copied_bytes) << " by copy_file_range, "
+                  << formatBytes(replace_buffered_bytes) << " through memory\n";
+        std::cout << "Output: " << formatBytes(image_bytes) << " in " << std::fixed
+                  << std::setprecision(2) << run_seconds << " s ("
+                  << formatBytes(run_seconds > 0 ? static_cast<uint64_t>(image_bytes / run_seconds)
+                                                 : 0)
+                  << "/s), " << images_preallocated << " of " << jobs.size()
+                  << " image(s) preallocated";
+        if (images_mapped > 0) {
+            std::cout << ", " << extents << " extent(s) across " << images_mapped << " image(s)";
+        }
+        std::cout << "\n";
+    }
+
 #ifdef HTTP_SUPPORT
     if (is_http_) {
         uint64_t downloaded = getBytesDownloaded();
-        std::cout << "Total downloaded: " << formatBytes(downloaded) << "\n";
+        std::cout << "Total downloaded: " << formatBytes(downloaded);
+        if (cache_) {
+            std::cout << " (cache: " << formatBytes(cache_->hitBytes()) << " hit, "
+                      << formatBytes(cache_->missBytes()) << " missed)";
+        }
+        std::cout << "\n";
+        if (mirror_) {
+            std::cout << "Local copy: " << formatBytes(mirror_->localBytes()) << " read locally, "
+                      << formatBytes(mirror_->fetchedBytes()) << " fetched, "
+                      << formatBytes(mirror_->completeBytes()) << " of "
+                      << formatBytes(mirror_->size()) << " present\n";
+        }
+        if (show_stats_) {
+            std::cout << "HTTP: " << ziprand_http_get_max_in_flight(zip_io_)
+                      << " request(s) in flight at most on "
+                      << ziprand_http_get_handle_count(zip_io_) << " handle(s), "
+                      << (ziprand_http_is_multiplexed(zip_io_) ? "HTTP/2 multiplexed"
+                                                               : "HTTP/1.1 connection pool")
+                      << "\n";
+            if (prefetch) {
+                std::cout << "Prefetch: " << prefetch_stats.requests << " request(s), "
+                          << formatBytes(prefetch_stats.fetched_bytes) << " fetched ("
+                          << formatBytes(prefetch_stats.gap_bytes) << " of gaps), "
+                          << formatBytes(prefetch_stats.hit_bytes) << " served, "
+                          << formatBytes(prefetch_stats.direct_bytes) << " read directly\n";
+            }
+        }
     }
 #endif
 
@@ -0,0 +1,288 @@
+#include "prefetcher.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace payload_dumper
+{
+
+RangePrefetcher::RangePrefetcher(Fetch fetch, std::vector<Range> ranges, const Config& config)
+    : fetch_(std::move(fetch)), config_(config), next_request_(0), held_bytes_(0),
+      stopping_(false), stats_{0, 0, 0, 0, 0}
+{
+    std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) {
+        return a.offset < b.offset;
+    });
+
+    for (const auto& range : ranges) {
+        if (range.length <= 0) {
+            continue;
+        }
+        if (!requests_.empty()) {
+            Request& last = requests_.back();
+            const int64_t last_end = last.offset + last.length;
+            const int64_t end = std::max(last_end, range.offset + range.length);
+            if (range.offset - last_end <= config_.max_gap &&
+                end - last.offset <= config_.max_request) {
+                // Overlapping and repeated ranges count once, as a reader
+                // consumes the bytes only once before the data is freed
+                if (end > last_end) {
+                    const int64_t begin = std::max(range.offset, last_end);
+                    last.needed += end - begin;
+                    if (begin == last_end) {
+                        last.unread.back().length = end - last.unread.back().offset;
+                    } else {
+                        last.unread.push_back({begin, end - begin});
+                    }
+                }
+                last.length = end - last.offset;
+                continue;
+            }
+        }
+        requests_.push_back({range.offset,
+                             range.length,
+                             static_cast<uint64_t>(range.length),
+                             {range},
+                             0,
+                             State::Pending,
+                             nullptr});
+    }
+}
+
+RangePrefetcher::~RangePrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    budget_cv_.notify_all();
+    ready_cv_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void RangePrefetcher::start()
+{
+    const int count = std::max(1, std::min<int>(config_.threads, static_cast<int>(requests_.size())));
+    for (int i = 0; i < count; ++i) {
+        threads_.emplace_back(&RangePrefetcher::worker, this);
+    }
+}
+
+size_t RangePrefetcher::requestCount() const
+{
+    return requests_.size();
+}
+
+RangePrefetcher::Stats RangePrefetcher::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void RangePrefetcher::worker()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        while (next_request_ < requests_.size() &&
+               requests_[next_request_].state != State::Pending) {
+            next_request_++;
+        }
+        if (stopping_ || next_request_ == requests_.size()) {
+            return;
+        }
+
+        Request& request = requests_[next_request_++];
+        // Data is only let in as readers release what they are done with; a
+        // request larger than the whole budget still goes when nothing is held
+        budget_cv_.wait(lock, [&] {
+            return stopping_ || request.state != State::Pending || held_bytes_ == 0 ||
+                   held_bytes_ + static_cast<uint64_t>(request.length) <= config_.budget;
+        });
+        if (stopping_) {
+            return;
+        }
+        if (request.state != State::Pending) {
+            continue;
+        }
+
+        request.state = State::Loading;
+        held_bytes_ += request.length;
+        lock.unlock();
+
+        std::unique_ptr<uint8_t[]> data(new (std::nothrow) uint8_t[request.length]);
+        bool ok = data && fetch_(data.get(), request.offset, request.length) == request.length;
+
+        lock.lock();
+        if (ok) {
+            request.data = std::move(data);
+            request.state = State::Ready;
+            stats_.requests++;
+            stats_.fetched_bytes += request.length;
+            stats_.gap_bytes += request.length - request.needed;
+            // Its ranges may have been discarded while it was in flight
+            releaseIfDone(request);
+        } else {
+            // Readers fall back to fetching their parts themselves
+            request.state = State::Failed;
+            held_bytes_ -= request.length;
+            budget_cv_.notify_all();
+        }
+        ready_cv_.notify_all();
+    }
+}
+
+bool RangePrefetcher::copyFrom(size_t index, uint8_t* out, int64_t offset, int64_t length)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    Request& request = requests_[index];
+    ready_cv_.wait(lock, [&] { return request.state != State::Loading; });
+
+    if (request.state == State::Ready) {
+        // The data stays until every wanted byte of it has been consumed,
+        // which includes this copy, so it can be made without the lock
+        const uint8_t* data = request.data.get() + (offset - request.offset);
+        request.copying++;
+        lock.unlock();
+        memcpy(out, data, static_cast<size_t>(length));
+        lock.lock();
+        request.copying--;
+
+        stats_.hit_bytes += length;
+        consume(request, offset, length);
+        releaseIfDone(request);
+        return true;
+    }
+
+    // Not fetched yet: the reader is ahead of the prefetch threads, so rather
+    // than wait it takes the whole request over and reads its part directly
+    if (request.state == State::Pending) {
+        request.state = State::Direct;
+        budget_cv_.notify_all();
+    }
+    lock.unlock();
+
+    bool ok = fetch_(out, offset, length) == length;
+    if (ok) {
+        lock.lock();
+        stats_.direct_bytes += length;
+    }
+    return ok;
+}
+
+void RangePrefetcher::consume(Request& request, int64_t offset, int64_t length)
+{
+    const int64_t end = offset + length;
+    std::vector<Range>& unread = request.unread;
+    auto first = std::lower_bound(unread.begin(),
+                                  unread.end(),
+                                  offset,
+                                  [](const Range& piece, int64_t value) {
+                                      return piece.offset + piece.length <= value;
+                                  });
+    auto last = first;
+    while (last != unread.end() && last->offset < end) {
+        ++last;
+    }
+    if (first == last) {
+        return;
+    }
+
+    // Whatever the removed span leaves of the first and last piece stays
+    Range kept[2];
+    size_t kept_count = 0;
+    if (first->offset < offset) {
+        kept[kept_count++] = {first->offset, offset - first->offset};
+    }
+    const int64_t last_end = (last - 1)->offset + (last - 1)->length;
+    if (last_end > end) {
+        kept[kept_count++] = {end, last_end - end};
+    }
+    const size_t at = static_cast<size_t>(first - unread.begin());
+    unread.erase(first, last);
+    unread.insert(unread.begin() + at, kept, kept + kept_count);
+}
+
+void RangePrefetcher::releaseIfDone(Request& request)
+{
+    if (!request.unread.empty()) {
+        return;
+    }
+    if (request.state == State::Pending) {
+        request.state = State::Released;
+        budget_cv_.notify_all();
+    } else if (request.state == State::Ready && request.copying == 0) {
+        request.data.reset();
+        request.state = State::Released;
+        held_bytes_ -= request.length;
+        budget_cv_.notify_all();
+    }
+}
+
+void RangePrefetcher::discard(const std::vector<Range>& ranges)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& range : ranges) {
+        const int64_t end = range.offset + range.length;
+        auto it = std::upper_bound(requests_.begin(),
+                                   requests_.end(),
+                                   range.offset,
+                                   [](int64_t value, const Request& request) {
+                                       return value < request.offset;
+                                   });
+        if (it != requests_.begin()) {
+            --it;
+        }
+        for (; it != requests_.end() && it->offset < end; ++it) {
+            consume(*it, range.offset, range.length);
+            releaseIfDone(*it);
+        }
+    }
+}
+
+int64_t RangePrefetcher::read(void* buffer, int64_t offset, int64_t length)
+{
+    if (length <= 0 || requests_.empty()) {
+        return 0;
+    }
+
+    // Request holding offset, then make sure consecutive requests cover the rest
+    auto it = std::upper_bound(requests_.begin(),
+                               requests_.end(),
+                               offset,
+                               [](int64_t value, const Request& request) {
+                                   return value < request.offset;
+                               });
+    if (it == requests_.begin()) {
+        return 0;
+    }
+    const size_t first = static_cast<size_t>(it - requests_.begin()) - 1;
+
+    const int64_t end = offset + length;
+    size_t last = first;
+    for (int64_t pos = offset;; ++last) {
+        if (last == requests_.size() || requests_[last].offset > pos ||
+            requests_[last].offset + requests_[last].length <= pos) {
+            return 0;
+        }
+        pos = requests_[last].offset + requests_[last].length;
+        if (pos >= end) {
+            break;
+        }
+    }
+
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    for (size_t index = first; index <= last; ++index) {
+        const int64_t piece_begin = std::max(offset, requests_[index].offset);
+        const int64_t piece_end =
+            std::min(end, requests_[index].offset + requests_[index].length);
+        if (!copyFrom(index, out + (piece_begin - offset), piece_begin, piece_end - piece_begin)) {
+            return -1;
+        }
+    }
+    return length;
+}
+
+} // namespace payload_dumper
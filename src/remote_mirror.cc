@@ -0,0 +1,315 @@
+#include "remote_mirror.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <utility>
+
+namespace payload_dumper
+{
+
+// Unit the copy is tracked in; missing data is fetched in whole blocks
+static constexpr uint64_t MIRROR_BLOCK_BYTES = 1024 * 1024;
+// Blocks the background fetch asks for in one request
+static constexpr uint64_t MIRROR_FILL_BLOCKS = 16;
+// Data stored between two updates of the bitmap on disk; each update syncs
+// the copy first
+static constexpr uint64_t MIRROR_PERSIST_BYTES = 64ull * 1024 * 1024;
+static constexpr const char* MIRROR_MAGIC = "PDUMIRR1";
+static constexpr const char* MIRROR_PARTS_SUFFIX = ".parts";
+
+RemoteMirror::RemoteMirror(Fetch fetch)
+    : fetch_(std::move(fetch)), file_size_(0), block_count_(0), bitmap_offset_(0),
+      resumed_(false), complete_bytes_(0), unpersisted_bytes_(0), stopping_(false),
+      local_bytes_(0), fetched_bytes_(0), store_failed_(false)
+{
+}
+
+RemoteMirror::~RemoteMirror()
+{
+    close();
+}
+
+bool RemoteMirror::open(const std::string& path, const std::string& validator, uint64_t file_size)
+{
+    file_size_ = file_size;
+    block_count_ = (file_size + MIRROR_BLOCK_BYTES - 1) / MIRROR_BLOCK_BYTES;
+
+    // The sidecar starts with what the bitmap is valid for
+    std::string header(MIRROR_MAGIC, strlen(MIRROR_MAGIC));
+    const uint64_t block_bytes = MIRROR_BLOCK_BYTES;
+    const uint32_t validator_length = static_cast<uint32_t>(validator.size());
+    header.append(reinterpret_cast<const char*>(&file_size), sizeof(file_size));
+    header.append(reinterpret_cast<const char*>(&block_bytes), sizeof(block_bytes));
+    header.append(reinterpret_cast<const char*>(&validator_length), sizeof(validator_length));
+    header += validator;
+    bitmap_offset_ = static_cast<int64_t>(header.size());
+    bitmap_.assign((block_count_ + 7) / 8, 0);
+
+    const std::string parts_path = path + MIRROR_PARTS_SUFFIX;
+    resumed_ = false;
+    if (!validator.empty()) {
+        PositionalFile data;
+        PositionalFile parts;
+        std::string found(header.size(), '\0');
+        resumed_ = data.open(path) && parts.open(parts_path) &&
+                   static_cast<uint64_t>(data.size()) == file_size &&
+                   parts.size() == bitmap_offset_ + static_cast<int64_t>(bitmap_.size()) &&
+                   parts.readAt(&found[0], 0, bitmap_offset_) == bitmap_offset_ &&
+                   found == header &&
+                   parts.readAt(bitmap_.data(), bitmap_offset_, bitmap_.size()) ==
+                       static_cast<int64_t>(bitmap_.size());
+    }
+    if (!resumed_) {
+        std::fill(bitmap_.begin(), bitmap_.end(), 0);
+    }
+
+    if (!data_.open(path, !resumed_) || !parts_.open(parts_path, !resumed_)) {
+        std::cerr << "Failed to open local copy: " << path << "\n";
+        close();
+        return false;
+    }
+    // A new copy is sparse until blocks arrive
+    if (!resumed_ &&
+        (!data_.extendTo(static_cast<int64_t>(file_size)) ||
+         !parts_.writeAt(header.data(), header.size(), 0) ||
+         !parts_.writeAt(bitmap_.data(), bitmap_.size(), bitmap_offset_))) {
+        std::cerr << "Failed to set up local copy: " << path << "\n";
+        close();
+        return false;
+    }
+
+    complete_bytes_ = 0;
+    for (uint64_t i = 0; i < block_count_; ++i) {
+        if (isDone(i)) {
+            complete_bytes_ += blockSize(i);
+        }
+    }
+    return true;
+}
+
+bool RemoteMirror::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    loaded_cv_.notify_all();
+    if (fill_thread_.joinable()) {
+        fill_thread_.join();
+    }
+    if (!data_.isOpen()) {
+        return true;
+    }
+
+    bool ok = persist();
+    ok = parts_.sync() && ok;
+    ok = data_.close() && ok;
+    ok = parts_.close() && ok;
+    return ok;
+}
+
+uint64_t RemoteMirror::size() const
+{
+    return file_size_;
+}
+
+bool RemoteMirror::resumed() const
+{
+    return resumed_;
+}
+
+uint64_t RemoteMirror::completeBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return complete_bytes_;
+}
+
+uint64_t RemoteMirror::localBytes() const
+{
+    return local_bytes_;
+}
+
+uint64_t RemoteMirror::fetchedBytes() const
+{
+    return fetched_bytes_;
+}
+
+bool RemoteMirror::isDone(uint64_t index) const
+{
+    return (bitmap_[index / 8] >> (index % 8)) & 1;
+}
+
+uint64_t RemoteMirror::blockSize(uint64_t index) const
+{
+    return std::min(MIRROR_BLOCK_BYTES, file_size_ - index * MIRROR_BLOCK_BYTES);
+}
+
+bool RemoteMirror::fetchRun(uint64_t first, uint64_t last, std::unique_ptr<uint8_t[]>& data)
+{
+    const uint64_t offset = first * MIRROR_BLOCK_BYTES;
+    const uint64_t length = std::min(file_size_, (last + 1) * MIRROR_BLOCK_BYTES) - offset;
+    data.reset(new (std::nothrow) uint8_t[length]);
+    const bool fetched = data && fetch_(data.get(), offset, static_cast<size_t>(length)) ==
+                                     static_cast<int64_t>(length);
+    const bool stored =
+        fetched && data_.writeAt(data.get(), static_cast<size_t>(length), static_cast<int64_t>(offset));
+    if (fetched && !stored && !store_failed_.exchange(true)) {
+        std::cerr << "Warning: failed to write to the local copy, it will stay incomplete\n";
+    }
+
+    bool persist_due = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Marked only once the data is in the copy, and only written to the
+        // sidecar by persist()
+        if (stored) {
+            for (uint64_t i = first; i <= last; ++i) {
+                bitmap_[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+                complete_bytes_ += blockSize(i);
+            }
+            unpersisted_bytes_ += length;
+            persist_due = unpersisted_bytes_ >= MIRROR_PERSIST_BYTES;
+        }
+        for (uint64_t i = first; i <= last; ++i) {
+            loading_.erase(i);
+        }
+    }
+    loaded_cv_.notify_all();
+
+    // A bitmap that failed to persist just means fetching these blocks again
+    if (persist_due) {
+        persist();
+    }
+    return fetched;
+}
+
+bool RemoteMirror::persist()
+{
+    std::lock_guard<std::mutex> persist_lock(persist_mutex_);
+    std::vector<uint8_t> bitmap;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bitmap = bitmap_;
+        unpersisted_bytes_ = 0;
+    }
+    // Every block set in the snapshot has been written; sync that data before
+    // the sidecar claims it, so a power loss cannot leave holes marked done
+    return data_.sync() && parts_.writeAt(bitmap.data(), bitmap.size(), bitmap_offset_);
+}
+
+int64_t RemoteMirror::read(void* buffer, uint64_t offset, size_t length)
+{
+    if (offset >= file_size_ || length == 0) {
+        return 0;
+    }
+
+    const uint64_t end = std::min<uint64_t>(offset + length, file_size_);
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    uint64_t pos = offset;
+    while (pos < end) {
+        const uint64_t index = pos / MIRROR_BLOCK_BYTES;
+
+        // Another thread fetching this block writes it to the copy for us
+        std::unique_lock<std::mutex> lock(mutex_);
+        loaded_cv_.wait(lock, [&] { return loading_.count(index) == 0; });
+
+        uint64_t last = index;
+        if (isDone(index)) {
+            while ((last + 1) * MIRROR_BLOCK_BYTES < end && isDone(last + 1)) {
+                ++last;
+            }
+            lock.unlock();
+
+            const uint64_t run_end = std::min(end, (last + 1) * MIRROR_BLOCK_BYTES);
+            const int64_t run_length = static_cast<int64_t>(run_end - pos);
+            if (data_.readAt(out + (pos - offset), static_cast<int64_t>(pos), run_length) !=
+                run_length) {
+                std::cerr << "Read failed in local copy at offset " << pos << "\n";
+                return -1;
+            }
+            local_bytes_ += run_end - pos;
+            pos = run_end;
+            continue;
+        }
+
+        // Take over the run of following blocks that are missing as well, so
+        // they arrive in one request
+        loading_.insert(index);
+        while ((last + 1) * MIRROR_BLOCK_BYTES < end && !isDone(last + 1) &&
+               loading_.count(last + 1) == 0) {
+            loading_.insert(++last);
+        }
+        lock.unlock();
+
+        std::unique_ptr<uint8_t[]> data;
+        if (!fetchRun(index, last, data)) {
+            return -1;
+        }
+
+        const uint64_t run_offset = index * MIRROR_BLOCK_BYTES;
+        const uint64_t run_end = std::min(end, (last + 1) * MIRROR_BLOCK_BYTES);
+        memcpy(out + (pos - offset), data.get() + (pos - run_offset), run_end - pos);
+        fetched_bytes_ += run_end - pos;
+        pos = run_end;
+    }
+    return static_cast<int64_t>(end - offset);
+}
+
+void RemoteMirror::startFill()
+{
+    if (!fill_thread_.joinable()) {
+        fill_thread_ = std::thread(&RemoteMirror::fill, this);
+    }
+}
+
+bool RemoteMirror::finishFill()
+{
+    if (fill_thread_.joinable()) {
+        fill_thread_.join();
+    }
+    return completeBytes() == file_size_;
+}
+
+void RemoteMirror::fill()
+{
+    uint64_t index = 0;
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (index < block_count_ && (isDone(index) || loading_.count(index) != 0)) {
+            ++index;
+        }
+        if (stopping_ || complete_bytes_ == file_size_) {
+            return;
+        }
+        // Blocks skipped because a reader had them are rechecked once it is
+        // done, in case its fetch failed
+        if (index == block_count_) {
+            loaded_cv_.wait(lock, [&] { return stopping_ || loading_.empty(); });
+            index = 0;
+            continue;
+        }
+
+        const uint64_t first = index;
+        uint64_t last = index;
+        loading_.insert(first);
+        while (last + 1 < block_count_ && last + 1 - first < MIRROR_FILL_BLOCKS &&
+               !isDone(last + 1) && loading_.count(last + 1) == 0) {
+            loading_.insert(++last);
+        }
+        lock.unlock();
+
+        std::unique_ptr<uint8_t[]> data;
+        if (!fetchRun(first, last, data)) {
+            std::cerr << "Warning: failed to fetch the rest of the local copy\n";
+            return;
+        }
+        if (store_failed_) {
+            return;
+        }
+        index = last + 1;
+    }
+}
+
+} // namespace payload_dumper
@@ -0,0 +1,150 @@
+#include "scratch_buffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace payload_dumper
+{
+
+// Transparent huge pages are 2 MiB on every architecture we build for
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+// Round small requests up so a buffer does not regrow for every slightly larger op
+static constexpr size_t MIN_CAPACITY = 64 * 1024;
+
+static std::atomic<bool> huge_pages{false};
+static std::atomic<uint64_t> allocation_count{0};
+static std::atomic<uint64_t> allocated_bytes{0};
+
+ScratchBuffer::ScratchBuffer() : data_(nullptr), size_(0), capacity_(0), mapped_(false)
+{
+}
+
+ScratchBuffer::~ScratchBuffer()
+{
+    release();
+}
+
+ScratchBuffer::ScratchBuffer(ScratchBuffer&& other) noexcept
+    : data_(other.data_), size_(other.size_), capacity_(other.capacity_), mapped_(other.mapped_)
+{
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.capacity_ = 0;
+    other.mapped_ = false;
+}
+
+ScratchBuffer& ScratchBuffer::operator=(ScratchBuffer&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        data_ = other.data_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+        mapped_ = other.mapped_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.capacity_ = 0;
+        other.mapped_ = false;
+    }
+    return *this;
+}
+
+void ScratchBuffer::release()
+{
+    if (!data_) {
+        return;
+    }
+#if defined(__linux__)
+    if (mapped_) {
+        munmap(data_, capacity_);
+    } else
+#endif
+    {
+        std::free(data_);
+    }
+    data_ = nullptr;
+    capacity_ = 0;
+    mapped_ = false;
+}
+
+uint8_t* ScratchBuffer::resize(size_t size)
+{
+    if (size > capacity_) {
+        size_t capacity = std::max({size, capacity_ + capacity_ / 2, MIN_CAPACITY});
+        release();
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (huge_pages && capacity >= HUGE_PAGE_SIZE) {
+            capacity = (capacity + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+            void* addr =
+                mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (addr != MAP_FAILED) {
+                madvise(addr, capacity, MADV_HUGEPAGE);
+                data_ = static_cast<uint8_t*>(addr);
+                mapped_ = true;
+            }
+        }
+#endif
+        if (!data_) {
+            data_ = static_cast<uint8_t*>(std::malloc(capacity));
+            if (!data_) {
+                size_ = 0;
+                throw std::bad_alloc();
+            }
+        }
+
+        capacity_ = capacity;
+        allocation_count++;
+        allocated_bytes += capacity;
+    }
+
+    size_ = size;
+    return data_;
+}
+
+void ScratchBuffer::clear()
+{
+    size_ = 0;
+}
+
+uint8_t* ScratchBuffer::data()
+{
+    return data_;
+}
+
+const uint8_t* ScratchBuffer::data() const
+{
+    return data_;
+}
+
+size_t ScratchBuffer::size() const
+{
+    return size_;
+}
+
+bool ScratchBuffer::empty() const
+{
+    return size_ == 0;
+}
+
+void ScratchBuffer::setHugePages(bool enabled)
+{
+    huge_pages = enabled;
+}
+
+uint64_t ScratchBuffer::allocationCount()
+{
+    return allocation_count;
+}
+
+uint64_t ScratchBuffer::allocatedBytes()
+{
+    return allocated_bytes;
+}
+
+} // namespace payload_dumper
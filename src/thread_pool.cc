@@ -0,0 +1,106 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace payload_dumper
+{
+
+WorkStealingPool::WorkStealingPool(int threads) : stats_{0, 0, 0.0, 0.0}
+{
+    threads = std::max(threads, 1);
+    for (int i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+}
+
+int WorkStealingPool::size() const
+{
+    return static_cast<int>(queues_.size());
+}
+
+const WorkStealingPool::Stats& WorkStealingPool::stats() const
+{
+    return stats_;
+}
+
+bool WorkStealingPool::popLocal(int index, Task& task)
+{
+    WorkerQueue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::steal(int index, Task& task)
+{
+    const int count = size();
+    for (int offset = 1; offset < count; ++offset) {
+        WorkerQueue& victim = *queues_[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(std::vector<Task> tasks)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int count = size();
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        queues_[i % count]->tasks.push_back(std::move(tasks[i]));
+    }
+
+    std::atomic<uint64_t> steals{0};
+    std::vector<Clock::time_point> finished(count);
+    auto start = Clock::now();
+
+    // Nothing is queued while the pool runs, so a thread that finds every
+    // deque empty is done for good.
+    auto worker = [&](int index) {
+        Task task;
+        while (true) {
+            if (popLocal(index, task)) {
+                task(index);
+            } else if (steal(index, task)) {
+                steals++;
+                task(index);
+            } else {
+                break;
+            }
+        }
+        finished[index] = Clock::now();
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < count; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto last = *std::max_element(finished.begin(), finished.end());
+    double tail_idle_ms = 0.0;
+    for (const auto& t : finished) {
+        tail_idle_ms += std::chrono::duration<double, std::milli>(last - t).count();
+    }
+
+    stats_.tasks += tasks.size();
+    stats_.steals += steals;
+    stats_.tail_idle_ms += tail_idle_ms;
+    stats_.wall_ms += std::chrono::duration<double, std::milli>(last - start).count();
+}
+
+} // namespace payload_dumper